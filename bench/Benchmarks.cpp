@@ -0,0 +1,239 @@
+#include "../src/Generator/Generator.hpp"
+#include "../src/Helpers/Helpers.hpp"
+#include "../src/Interval/Section.hpp"
+#include "../src/Logger/Logger.hpp"
+#include "../src/MarkovChain/MarkovChain.hpp"
+#include "../src/Model/Model.hpp"
+#include "../src/Model/WindowModel.hpp"
+#include "../src/Results/WindowSectionSplitResult.hpp"
+#include "../src/SegTree/SegTree.hpp"
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+// models log their progress, benchmarks keep only the output of google benchmark
+Logger logger("/dev/null");
+
+// the DPs, and the section joins built on them, are quadratic in the number of reference intervals, larger inputs only
+// run the linear benchmarks
+const size_t QUADRATIC_MAX_REF_INTERVALS = 5000;
+
+// windows of every dataset, as a fraction of the chromosome size
+const long long WINDOWS_PER_CHROMOSOME = 50, STEPS_PER_WINDOW = 5;
+
+// one chromosome worth of sorted, merged intervals
+struct Dataset {
+  std::string name;
+  // text files are loaded again by the load_intervals benchmark
+  std::string ref_path, query_path;
+  long long chr_size;
+  std::vector<Interval> ref_intervals, query_intervals, windows;
+};
+
+static std::vector<Interval> dense_windows(long long chr_size) {
+  long long size = std::max(chr_size / WINDOWS_PER_CHROMOSOME, 1LL), step = std::max(size / STEPS_PER_WINDOW, 1LL);
+  std::vector<Interval> windows;
+  for (long long begin = 0; begin + size <= chr_size; begin += step)
+    windows.push_back({"chr1", begin, begin + size});
+  return windows;
+}
+
+static Dataset load_dataset(const std::string &name, const std::string &ref_path, const std::string &query_path,
+                            long long chr_size) {
+  Dataset dataset{name, ref_path, query_path, chr_size};
+  dataset.ref_intervals = merge_non_disjoint_intervals(load_intervals(ref_path));
+  dataset.query_intervals = merge_non_disjoint_intervals(load_intervals(query_path));
+  dataset.windows = dense_windows(chr_size);
+  return dataset;
+}
+
+// about `ref_count` reference intervals sampled by the generator, seeded so that every run measures the same input
+static Dataset synthetic_dataset(size_t ref_count) {
+  Dataset dataset{"synthetic_" + std::to_string(ref_count)};
+  // reference like ref_1000_1, with intervals of 500 bases every 5500 bases, ten times denser query
+  dataset.chr_size = ref_count * 5500;
+  ChrSizesVector chr_sizes = {{"chr1", dataset.chr_size}};
+  dataset.ref_intervals = generate_intervals(chr_sizes, {markov_chain_from_density(1 / 11.L, 500)}, ref_count, 0);
+  dataset.query_intervals = generate_intervals(chr_sizes, {markov_chain_from_density(0.5, 500)}, ref_count, 1);
+  dataset.windows = dense_windows(dataset.chr_size);
+  return dataset;
+}
+
+// sections of the dense windows with their probabilities, as built by the fast window algorithm
+struct EvaluatedSections {
+  MarkovChain markov_chain;
+  std::vector<Section> sections;
+  std::vector<Interval> spans;
+};
+
+static EvaluatedSections evaluate_sections(const Dataset &dataset) {
+  WindowSectionSplitResult split_result =
+      split_windows_into_non_overlapping_sections(dataset.windows, dataset.ref_intervals, dataset.query_intervals);
+  EvaluatedSections evaluated{MarkovChain(dataset.chr_size, dataset.query_intervals), split_result.get_sections(),
+                              split_result.get_spans()};
+  WindowModel().eval_sections_new(evaluated.sections, dataset.ref_intervals, dataset.query_intervals,
+                                  evaluated.markov_chain);
+  return evaluated;
+}
+
+static void BM_load_intervals(benchmark::State &state, const Dataset &dataset) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(load_intervals(dataset.ref_path));
+    benchmark::DoNotOptimize(load_intervals(dataset.query_path));
+  }
+  state.SetItemsProcessed(state.iterations() * (dataset.ref_intervals.size() + dataset.query_intervals.size()));
+}
+
+static void BM_count_overlaps_single_chr(benchmark::State &state, const Dataset &dataset) {
+  for (auto _ : state)
+    benchmark::DoNotOptimize(count_overlaps_single_chr(dataset.ref_intervals, dataset.query_intervals));
+  state.SetItemsProcessed(state.iterations() * (dataset.ref_intervals.size() + dataset.query_intervals.size()));
+}
+
+static void BM_split_windows_into_non_overlapping_sections(benchmark::State &state, const Dataset &dataset) {
+  for (auto _ : state)
+    benchmark::DoNotOptimize(
+        split_windows_into_non_overlapping_sections(dataset.windows, dataset.ref_intervals, dataset.query_intervals));
+  state.SetItemsProcessed(state.iterations() * dataset.windows.size());
+}
+
+static void BM_eval_probs_single_chr_direct(benchmark::State &state, const Dataset &dataset) {
+  MarkovChain markov_chain(dataset.chr_size, dataset.query_intervals);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(Model::eval_probs_single_chr_direct(dataset.ref_intervals, dataset.query_intervals,
+                                                                 markov_chain, dataset.chr_size));
+  state.counters["dp_cells"] = dataset.ref_intervals.size() * (dataset.ref_intervals.size() + 1) / 2;
+}
+
+static void BM_eval_probs_single_chr_scaled(benchmark::State &state, const Dataset &dataset) {
+  MarkovChain markov_chain(dataset.chr_size, dataset.query_intervals);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(Model::eval_probs_single_chr_scaled(dataset.ref_intervals, dataset.query_intervals,
+                                                                 markov_chain, dataset.chr_size));
+  state.counters["dp_cells"] = dataset.ref_intervals.size() * (dataset.ref_intervals.size() + 1) / 2;
+}
+
+static void BM_eval_probs_single_chr_direct_new(benchmark::State &state, const Dataset &dataset) {
+  MarkovChain markov_chain(dataset.chr_size, dataset.query_intervals);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(
+        Model::eval_probs_single_chr_direct_new(dataset.ref_intervals, 0, dataset.chr_size, markov_chain));
+  state.counters["dp_cells"] = dataset.ref_intervals.size() * (dataset.ref_intervals.size() + 1);
+}
+
+// the per chromosome distributions of the dataset split into `state.range(0)` equal chromosomes
+static void BM_joint_logprobs_by_chr(benchmark::State &state, const Dataset &dataset) {
+  size_t chromosomes = state.range(0), chunk = (dataset.ref_intervals.size() + chromosomes - 1) / chromosomes;
+  MarkovChain markov_chain(dataset.chr_size, dataset.query_intervals);
+  std::vector<std::vector<long double>> probs_by_chr;
+  for (size_t begin = 0; begin < dataset.ref_intervals.size(); begin += chunk) {
+    std::vector<Interval> ref_intervals(dataset.ref_intervals.begin() + begin,
+                                        dataset.ref_intervals.begin() +
+                                            std::min(begin + chunk, dataset.ref_intervals.size()));
+    probs_by_chr.push_back(Model::eval_probs_single_chr_scaled(ref_intervals, dataset.query_intervals, markov_chain,
+                                                               dataset.chr_size));
+  }
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(joint_logprobs(probs_by_chr));
+}
+
+static void BM_joint_logprobs_multi_probs(benchmark::State &state, const Dataset &dataset) {
+  MarkovChain markov_chain(dataset.chr_size, dataset.query_intervals);
+  size_t half = dataset.ref_intervals.size() / 2;
+  long long middle = dataset.ref_intervals[half].begin;
+  MultiProbs left = Model::eval_probs_single_chr_direct_new(
+      std::vector<Interval>(dataset.ref_intervals.begin(), dataset.ref_intervals.begin() + half), 0, middle,
+      markov_chain);
+  MultiProbs right = Model::eval_probs_single_chr_direct_new(
+      std::vector<Interval>(dataset.ref_intervals.begin() + half, dataset.ref_intervals.end()), middle,
+      dataset.chr_size, markov_chain);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(joint_logprobs(left, right));
+}
+
+// joins every pair of neighbouring sections
+static void BM_join_sections_new(benchmark::State &state, const Dataset &dataset) {
+  EvaluatedSections evaluated = evaluate_sections(dataset);
+  for (auto _ : state) {
+    for (size_t idx = 0; idx + 1 < evaluated.sections.size(); idx++)
+      benchmark::DoNotOptimize(
+          join_sections_new(evaluated.sections[idx], evaluated.sections[idx + 1], evaluated.markov_chain));
+  }
+  state.SetItemsProcessed(state.iterations() * (evaluated.sections.size() - 1));
+}
+
+static void BM_segtree_build(benchmark::State &state, const Dataset &dataset) {
+  EvaluatedSections evaluated = evaluate_sections(dataset);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(
+        SegTree<Section>(join_sections_new_segtree, Section(), evaluated.sections, evaluated.markov_chain));
+  state.SetItemsProcessed(state.iterations() * evaluated.sections.size());
+}
+
+// answers the spans of all windows, the way the fast window algorithm does
+static void BM_segtree_query(benchmark::State &state, const Dataset &dataset) {
+  EvaluatedSections evaluated = evaluate_sections(dataset);
+  SegTree<Section> segtree(join_sections_new_segtree, Section(), evaluated.sections, evaluated.markov_chain);
+  std::vector<std::pair<int, int>> ranges;
+  for (const Interval &span : evaluated.spans)
+    ranges.push_back({span.begin, span.end});
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(segtree.query_batch(ranges));
+  state.SetItemsProcessed(state.iterations() * ranges.size());
+}
+
+using DatasetBenchmark = void (*)(benchmark::State &, const Dataset &);
+
+int main(int argc, char **argv) {
+  // paths are relative to the repository root, like in the tests
+  static std::vector<Dataset> datasets = {
+      load_dataset("g24_8", "test_data/g24_8.ref.tsv", "test_data/g24_8.query.tsv", 1000000),
+      load_dataset("1000_1", "test_data/ref_1000_1.tsv", "test_data/query_1000_1.tsv", 100000000),
+      synthetic_dataset(1000),
+      synthetic_dataset(4000),
+      synthetic_dataset(16000),
+  };
+
+  std::vector<std::pair<std::string, DatasetBenchmark>> linear_benchmarks = {
+      {"count_overlaps_single_chr", BM_count_overlaps_single_chr},
+      {"split_windows_into_non_overlapping_sections", BM_split_windows_into_non_overlapping_sections},
+  };
+  std::vector<std::pair<std::string, DatasetBenchmark>> quadratic_benchmarks = {
+      {"eval_probs_single_chr_direct", BM_eval_probs_single_chr_direct},
+      {"eval_probs_single_chr_scaled", BM_eval_probs_single_chr_scaled},
+      {"eval_probs_single_chr_direct_new", BM_eval_probs_single_chr_direct_new},
+      {"joint_logprobs_multi_probs", BM_joint_logprobs_multi_probs},
+      {"join_sections_new", BM_join_sections_new},
+      {"segtree_build", BM_segtree_build},
+      {"segtree_query", BM_segtree_query},
+  };
+
+  for (const Dataset &dataset : datasets) {
+    if (!dataset.ref_path.empty())
+      benchmark::RegisterBenchmark(("load_intervals/" + dataset.name).c_str(), BM_load_intervals, dataset)
+          ->Unit(benchmark::kMillisecond);
+    for (const auto &[name, function] : linear_benchmarks)
+      benchmark::RegisterBenchmark((name + "/" + dataset.name).c_str(), function, dataset)
+          ->Unit(benchmark::kMillisecond);
+    if (dataset.ref_intervals.size() > QUADRATIC_MAX_REF_INTERVALS)
+      continue;
+    for (const auto &[name, function] : quadratic_benchmarks)
+      benchmark::RegisterBenchmark((name + "/" + dataset.name).c_str(), function, dataset)
+          ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("joint_logprobs_by_chr/" + dataset.name).c_str(), BM_joint_logprobs_by_chr, dataset)
+        ->Arg(8)
+        ->Arg(64)
+        ->Unit(benchmark::kMillisecond);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Scaling study of emcdp on synthetic data.
+
+For every chromosome size a reference and a query are sampled with `emcdp generate`, then the genome-wide p-value and
+the dense windows of every algorithm are evaluated on them. Wall time and peak memory of every run are written as TSV.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+DEFAULT_SIZES = [10**6, 10**7, 10**8]
+DEFAULT_ALGORITHMS = ["naive", "fast", "sliding", "sparse"]
+COLUMNS = ["chr_size", "ref_density", "query_density", "windows_size", "windows_step", "algorithm", "seconds",
+           "max_rss_mb", "exit_code"]
+
+
+def run(command):
+    """Runs the command, returns its wall time in seconds, peak resident memory in megabytes and exit code."""
+    start = time.monotonic()
+    process = subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(process.pid, 0)
+    seconds = time.monotonic() - start
+    # ru_maxrss is in kilobytes on linux
+    return seconds, usage.ru_maxrss / 1024, os.waitstatus_to_exitcode(status)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--emcdp", default="bin/emcdp", help="path to the emcdp binary")
+    parser.add_argument("--sizes", type=int, nargs="+", default=DEFAULT_SIZES, help="chromosome sizes to sweep")
+    parser.add_argument("--algorithms", nargs="+", default=DEFAULT_ALGORITHMS, help="window algorithms to run")
+    parser.add_argument("--ref-density", type=float, default=0.05)
+    parser.add_argument("--ref-length", type=float, default=500)
+    parser.add_argument("--query-density", type=float, default=0.5)
+    parser.add_argument("--query-length", type=float, default=500)
+    parser.add_argument("--windows-per-chromosome", type=int, default=1000,
+                        help="windows size is the chromosome size divided by this")
+    parser.add_argument("--steps-per-window", type=int, default=5, help="windows size divided by windows step")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--o", default="-", help="TSV with the results, standard output by default")
+    args = parser.parse_args()
+
+    output = sys.stdout if args.o == "-" else open(args.o, "w")
+    output.write("\t".join(COLUMNS) + "\n")
+
+    with tempfile.TemporaryDirectory() as work_dir:
+        for chr_size in args.sizes:
+            chr_sizes_path = os.path.join(work_dir, "sizes.tsv")
+            with open(chr_sizes_path, "w") as chr_sizes_file:
+                chr_sizes_file.write(f"chr1\t{chr_size}\n")
+
+            prefix = os.path.join(work_dir, "synthetic")
+            _, _, exit_code = run([args.emcdp, "generate", "--chs", chr_sizes_path, "--o", prefix,
+                                   "--generate.seed", str(args.seed), "--generate.format", "binary",
+                                   "--generate.ref_density", str(args.ref_density),
+                                   "--generate.ref_length", str(args.ref_length),
+                                   "--generate.query_density", str(args.query_density),
+                                   "--generate.query_length", str(args.query_length)])
+            if exit_code:
+                sys.exit(f"emcdp generate failed for chromosome size {chr_size}")
+
+            base = [args.emcdp, "--r", prefix + ".ref.bin", "--q", prefix + ".query.bin", "--chs", chr_sizes_path,
+                    "--o", os.path.join(work_dir, "output.tsv"), "--log", os.path.join(work_dir, "log.txt")]
+            windows_size = max(chr_size // args.windows_per_chromosome, 1)
+            windows_step = max(windows_size // args.steps_per_window, 1)
+
+            runs = [("genome", "", "", base)]
+            for algorithm in args.algorithms:
+                runs.append((algorithm, windows_size, windows_step,
+                             base + ["--windows.source", "dense", "--windows.size", str(windows_size),
+                                     "--windows.step", str(windows_step), "--algorithm", algorithm]))
+
+            for algorithm, size, step, command in runs:
+                seconds, max_rss_mb, exit_code = run(command)
+                row = [chr_size, args.ref_density, args.query_density, size, step, algorithm, f"{seconds:.3f}",
+                       f"{max_rss_mb:.1f}", exit_code]
+                output.write("\t".join(map(str, row)) + "\n")
+                output.flush()
+
+
+if __name__ == "__main__":
+    main()
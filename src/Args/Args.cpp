@@ -5,7 +5,18 @@
 Args::Args(Logger &logger) : logger(logger) {}
 
 void Args::parse_args(int argc, char *argv[]) {
-  for (int i = 1; i < argc; i++) {
+  int first_flag = 1;
+  if (argc > 1 && std::string(argv[1]) == "convert") {
+    convert = true;
+    first_flag = 2;
+    logger.info("Parsed mode: convert");
+  } else if (argc > 1 && std::string(argv[1]) == "generate") {
+    generate = true;
+    first_flag = 2;
+    logger.info("Parsed mode: generate");
+  }
+
+  for (int i = first_flag; i < argc; i++) {
     std::string flag = argv[i];
     if (flag == "--chs") {
       if (i + 1 < argc) {
@@ -28,6 +39,13 @@ void Args::parse_args(int argc, char *argv[]) {
       } else {
         log_failed_to_parse_args(flag);
       }
+    } else if (flag == "--i") {
+      if (i + 1 < argc) {
+        input_file_path = argv[++i];
+        logger.info("Parsed --i: " + input_file_path);
+      } else {
+        log_failed_to_parse_args(flag);
+      }
     } else if (flag == "--o") {
       if (i + 1 < argc) {
         output_file_path = argv[++i];
@@ -42,6 +60,13 @@ void Args::parse_args(int argc, char *argv[]) {
       } else {
         log_failed_to_parse_args(flag);
       }
+    } else if (flag == "--profile") {
+      if (i + 1 < argc) {
+        profile_file_path = argv[++i];
+        logger.info("Parsed --profile: " + profile_file_path);
+      } else {
+        log_failed_to_parse_args(flag);
+      }
     } else if (flag == "--windows.source") {
       if (i + 1 < argc) {
         windows_source = argv[++i];
@@ -103,6 +128,74 @@ void Args::parse_args(int argc, char *argv[]) {
       } else {
         log_failed_to_parse_args(flag);
       }
+    } else if (flag == "--epsilon") {
+      if (i + 1 < argc) {
+        epsilon = std::stold(argv[++i]);
+        if (epsilon < 0 || epsilon >= 1) {
+          logger.error("--epsilon should be in the range [0, 1).");
+          exit(1);
+        }
+        logger.info("Parsed --epsilon: " + std::to_string(epsilon));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--memory.budget") {
+      if (i + 1 < argc) {
+        memory_budget = std::stoll(argv[++i]);
+        if (memory_budget < 0) {
+          logger.error("--memory.budget should be non-negative.");
+          exit(1);
+        }
+        logger.info("Parsed --memory.budget: " + std::to_string(memory_budget));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--generate.seed") {
+      if (i + 1 < argc) {
+        generate_seed = std::stoull(argv[++i]);
+        logger.info("Parsed --generate.seed: " + std::to_string(generate_seed));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--generate.ref_density") {
+      if (i + 1 < argc) {
+        generate_ref_density = std::stold(argv[++i]);
+        logger.info("Parsed --generate.ref_density: " + std::to_string(generate_ref_density));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--generate.ref_length") {
+      if (i + 1 < argc) {
+        generate_ref_length = std::stold(argv[++i]);
+        logger.info("Parsed --generate.ref_length: " + std::to_string(generate_ref_length));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--generate.query_density") {
+      if (i + 1 < argc) {
+        generate_query_density = std::stold(argv[++i]);
+        logger.info("Parsed --generate.query_density: " + std::to_string(generate_query_density));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--generate.query_length") {
+      if (i + 1 < argc) {
+        generate_query_length = std::stold(argv[++i]);
+        logger.info("Parsed --generate.query_length: " + std::to_string(generate_query_length));
+      } else {
+        log_failed_to_parse_args(flag);
+      }
+    } else if (flag == "--generate.format") {
+      if (i + 1 < argc) {
+        generate_format = argv[++i];
+        if (generate_format != "tsv" && generate_format != "binary") {
+          logger.error("--generate.format can only have values of tsv or binary.");
+          exit(1);
+        }
+        logger.info("Parsed --generate.format: " + generate_format);
+      } else {
+        log_failed_to_parse_args(flag);
+      }
     } else if (flag == "--test") {
       run_tests = true;
     } else if (flag == "--help") {
@@ -116,8 +209,18 @@ void Args::parse_args(int argc, char *argv[]) {
 }
 
 void Args::debug_args() {
+  logger.debug("convert: " + std::to_string(convert));
+  logger.debug("generate: " + std::to_string(generate));
+  logger.debug("generate.seed: " + std::to_string(generate_seed));
+  logger.debug("generate.ref_density: " + std::to_string(generate_ref_density));
+  logger.debug("generate.ref_length: " + std::to_string(generate_ref_length));
+  logger.debug("generate.query_density: " + std::to_string(generate_query_density));
+  logger.debug("generate.query_length: " + std::to_string(generate_query_length));
+  logger.debug("generate.format: " + generate_format);
+  logger.debug("input: " + input_file_path);
   logger.debug("output: " + output_file_path);
   logger.debug("log: " + log_file_path);
+  logger.debug("profile: " + profile_file_path);
   logger.debug("ref_intervals_file_path: " + ref_intervals_file_path);
   logger.debug("query_intervals_file_path: " + query_intervals_file_path);
   logger.debug("chr_size_file_path: " + chr_size_file_path);
@@ -128,6 +231,8 @@ void Args::debug_args() {
   logger.debug("windows.path: " + windows_path);
   logger.debug("windows.size: " + std::to_string(windows_size));
   logger.debug("windows.step: " + std::to_string(windows_step));
+  logger.debug("epsilon: " + std::to_string(epsilon));
+  logger.debug("memory.budget: " + std::to_string(memory_budget));
   logger.debug("run_tests: " + std::to_string(run_tests));
   logger.debug("show_help: " + std::to_string(show_help));
 }
@@ -147,12 +252,24 @@ void Args::check_required_args() {
     return;
 
   std::string missing_args;
-  if (query_intervals_file_path.empty())
-    missing_args += " --q";
-  if (ref_intervals_file_path.empty())
-    missing_args += " --r";
-  if (chr_size_file_path.empty())
-    missing_args += " --chs";
+  if (convert) {
+    if (input_file_path.empty())
+      missing_args += " --i";
+    if (output_file_path.empty())
+      missing_args += " --o";
+  } else if (generate) {
+    if (chr_size_file_path.empty())
+      missing_args += " --chs";
+    if (output_file_path.empty())
+      missing_args += " --o";
+  } else {
+    if (query_intervals_file_path.empty())
+      missing_args += " --q";
+    if (ref_intervals_file_path.empty())
+      missing_args += " --r";
+    if (chr_size_file_path.empty())
+      missing_args += " --chs";
+  }
 
   if (!missing_args.empty()) {
     logger.error("Following arguments are missing:" + missing_args + ".");
@@ -3,6 +3,7 @@
 
 #include "../Enums/Enums.hpp"
 #include "../Logger/Logger.hpp"
+#include <cstdint>
 #include <string>
 
 class Args {
@@ -12,11 +13,25 @@ public:
   void parse_args(int argc, char *argv[]);
   void debug_args();
 
+  // `emcdp convert` writes the intervals from --i into the binary format at --o
+  bool convert = false;
+  // `emcdp generate` samples a synthetic reference and query over --chs into <--o>.ref and <--o>.query, from the
+  // densities below, or from chains fitted to --r and --q when these are given
+  bool generate = false;
+  uint64_t generate_seed = 1;
+  long double generate_ref_density = 0.05;
+  long double generate_ref_length = 500;
+  long double generate_query_density = 0.5;
+  long double generate_query_length = 500;
+  std::string generate_format = "tsv";
+  std::string input_file_path;
   std::string chr_size_file_path;
   std::string ref_intervals_file_path;
   std::string query_intervals_file_path;
   std::string output_file_path;
   std::string log_file_path;
+  // if set, time and counters of every phase of the run are written into this file as JSON
+  std::string profile_file_path;
   Statistic statistic = Statistic::OVERLAPS;
   Algorithm algorithm = Algorithm::NAIVE;
   Significance significance = Significance::ENRICHMENT;
@@ -24,6 +39,9 @@ public:
   std::string windows_path;
   long long windows_size;
   long long windows_step;
+  long double epsilon = 0;
+  // in megabytes, sparse tables of chromosomes that would take more fall back to a segment tree
+  long long memory_budget = 4096;
   bool run_tests = false;
   bool show_help = false;
 
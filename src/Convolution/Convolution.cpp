@@ -0,0 +1,261 @@
+#include "Convolution.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <numbers>
+#include <unordered_map>
+#include <vector>
+
+const long double ld_inf = std::numeric_limits<long double>::infinity();
+
+// log values inside one block differ by at most this much, so after scaling by the block maximum every value is in
+// [1e-6, 1] and every entry of a block pair convolution has at least one term >= 1e-12
+const long double BLOCK_LOG_RANGE = std::log(1e6L);
+
+// block pairs with at most this many products are convolved directly
+const size_t DIRECT_CONVOLUTION_LIMIT = 4096;
+
+// FFT results whose estimated relative error is above this are recomputed exactly
+const long double FFT_RELATIVE_TOLERANCE = 1e-9L;
+
+// block pairs contributing less than exp(-NEGLIGIBLE_LOG_GAP) relative to every result entry they touch are skipped,
+// this is far below the precision of long double
+const long double NEGLIGIBLE_LOG_GAP = 70;
+
+// contiguous range [begin, end) of finite log probabilities with the extremes `min` and `max`
+struct Block {
+  size_t begin, end;
+  long double min, max;
+};
+
+static std::vector<Block> split_into_blocks(const std::vector<long double> &logprobs) {
+  std::vector<Block> blocks;
+
+  size_t idx = 0;
+  while (idx < logprobs.size()) {
+    if (logprobs[idx] == -ld_inf) {
+      idx++;
+      continue;
+    }
+
+    Block block{idx, idx + 1, logprobs[idx], logprobs[idx]};
+    for (idx++; idx < logprobs.size() && logprobs[idx] != -ld_inf; idx++) {
+      long double new_max = std::max(block.max, logprobs[idx]), new_min = std::min(block.min, logprobs[idx]);
+      if (new_max - new_min > BLOCK_LOG_RANGE)
+        break;
+      block.max = new_max;
+      block.min = new_min;
+      block.end = idx + 1;
+    }
+
+    blocks.push_back(block);
+  }
+
+  return blocks;
+}
+
+static long double log_add(long double log_x, long double log_y) {
+  if (log_x < log_y)
+    std::swap(log_x, log_y);
+  if (log_y == -ld_inf)
+    return log_x;
+  return log_x + std::log1p(std::exp(log_y - log_x));
+}
+
+static std::vector<long double> scale_block(const std::vector<long double> &logprobs, const Block &block) {
+  std::vector<long double> scaled(block.end - block.begin);
+  for (size_t idx = block.begin; idx < block.end; idx++)
+    scaled[idx - block.begin] = std::exp(logprobs[idx] - block.max);
+  return scaled;
+}
+
+// exact value of the k-th entry of the convolution of two scaled blocks
+static long double convolve_entry(const std::vector<long double> &a, const std::vector<long double> &b, size_t k) {
+  size_t lo = k + 1 > b.size() ? k + 1 - b.size() : 0, hi = std::min(k + 1, a.size());
+  long double sum = 0;
+  for (size_t i = lo; i < hi; i++)
+    sum += a[i] * b[k - i];
+  return sum;
+}
+
+// roots of unity are computed directly instead of by repeated multiplication to keep the error bound valid. the
+// trigonometric functions dominate small transforms, so the roots are cached per thread for every transform size
+static const std::vector<std::complex<long double>> &get_roots_of_unity(size_t n) {
+  thread_local std::unordered_map<size_t, std::vector<std::complex<long double>>> roots_by_size;
+  std::vector<std::complex<long double>> &roots = roots_by_size[n];
+  if (roots.size() != n / 2) {
+    roots.resize(n / 2);
+    for (size_t j = 0; j < n / 2; j++) {
+      long double angle = 2 * std::numbers::pi_v<long double> * j / n;
+      roots[j] = std::complex<long double>(std::cos(angle), std::sin(angle));
+    }
+  }
+  return roots;
+}
+
+static void fft(std::vector<std::complex<long double>> &values, bool invert) {
+  size_t n = values.size();
+
+  for (size_t i = 1, j = 0; i < n; i++) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(values[i], values[j]);
+  }
+
+  const std::vector<std::complex<long double>> &roots = get_roots_of_unity(n);
+
+  for (size_t len = 2; len <= n; len <<= 1) {
+    size_t stride = n / len;
+    for (size_t start = 0; start < n; start += len) {
+      for (size_t j = 0; j < len / 2; j++) {
+        std::complex<long double> root = invert ? std::conj(roots[j * stride]) : roots[j * stride];
+        std::complex<long double> u = values[start + j], v = values[start + j + len / 2] * root;
+        values[start + j] = u + v;
+        values[start + j + len / 2] = u - v;
+      }
+    }
+  }
+
+  if (invert)
+    for (std::complex<long double> &value : values)
+      value /= (long double)n;
+}
+
+// convolution of two scaled blocks, entries that FFT can't compute accurately enough are computed exactly
+static std::vector<long double> convolve_scaled(const std::vector<long double> &a, const std::vector<long double> &b) {
+  size_t result_size = a.size() + b.size() - 1;
+  std::vector<long double> result(result_size);
+
+  if (a.size() * b.size() <= DIRECT_CONVOLUTION_LIMIT) {
+    for (size_t i = 0; i < a.size(); i++)
+      for (size_t j = 0; j < b.size(); j++)
+        result[i + j] += a[i] * b[j];
+    return result;
+  }
+
+  size_t n = 1;
+  while (n < result_size)
+    n <<= 1;
+
+  std::vector<std::complex<long double>> fa(a.begin(), a.end()), fb(b.begin(), b.end());
+  fa.resize(n);
+  fb.resize(n);
+  fft(fa, false);
+  fft(fb, false);
+  for (size_t idx = 0; idx < n; idx++)
+    fa[idx] *= fb[idx];
+  fft(fa, true);
+
+  // standard bound on the absolute error of FFT convolution
+  long double norm_a = 0, norm_b = 0;
+  for (long double value : a)
+    norm_a += value * value;
+  for (long double value : b)
+    norm_b += value * value;
+  long double error_bound = 4 * std::numeric_limits<long double>::epsilon() * std::log2((long double)n) *
+                            std::sqrt(norm_a) * std::sqrt(norm_b);
+
+  for (size_t k = 0; k < result_size; k++) {
+    long double value = fa[k].real();
+    result[k] = value * FFT_RELATIVE_TOLERANCE > error_bound ? value : convolve_entry(a, b, k);
+  }
+
+  return result;
+}
+
+// every result entry covered by a block pair has at least one term >= exp(min_a + min_b), so the largest such bound
+// over all pairs covering an entry is a lower bound on it. returns these lower bounds for all entries
+static std::vector<long double> get_result_lower_bounds(const std::vector<Block> &blocks_a,
+                                                        const std::vector<Block> &blocks_b, size_t result_size) {
+  // segment tree with range chmax updates and point queries, no push down is needed
+  size_t n = 1;
+  while (n < result_size)
+    n <<= 1;
+  std::vector<long double> tree(n << 1, -ld_inf);
+
+  for (const Block &block_a : blocks_a) {
+    for (const Block &block_b : blocks_b) {
+      long double bound = block_a.min + block_b.min;
+      for (size_t l = block_a.begin + block_b.begin + n, r = block_a.end + block_b.end - 1 + n; l < r;
+           l >>= 1, r >>= 1) {
+        if (l & 1) {
+          tree[l] = std::max(tree[l], bound);
+          l++;
+        }
+        if (r & 1) {
+          r--;
+          tree[r] = std::max(tree[r], bound);
+        }
+      }
+    }
+  }
+
+  for (size_t idx = 2; idx < (n << 1); idx++)
+    tree[idx] = std::max(tree[idx], tree[idx >> 1]);
+
+  return std::vector<long double>(tree.begin() + n, tree.begin() + n + result_size);
+}
+
+// sparse table for range minimum queries over the lower bounds
+static std::vector<std::vector<long double>> build_min_sparse_table(const std::vector<long double> &values) {
+  std::vector<std::vector<long double>> table{values};
+  for (size_t len = 2; len <= values.size(); len <<= 1) {
+    const std::vector<long double> &prev = table.back();
+    std::vector<long double> level(values.size() - len + 1);
+    for (size_t idx = 0; idx < level.size(); idx++)
+      level[idx] = std::min(prev[idx], prev[idx + len / 2]);
+    table.push_back(level);
+  }
+  return table;
+}
+
+// minimum over [l, r)
+static long double query_min_sparse_table(const std::vector<std::vector<long double>> &table, size_t l, size_t r) {
+  size_t level = std::bit_width(r - l) - 1;
+  return std::min(table[level][l], table[level][r - (1ULL << level)]);
+}
+
+std::vector<long double> convolve_logprobs(const std::vector<long double> &a, const std::vector<long double> &b) {
+  if (a.empty() || b.empty())
+    return {};
+
+  size_t result_size = a.size() + b.size() - 1;
+  std::vector<long double> result(result_size, -ld_inf);
+  std::vector<Block> blocks_a = split_into_blocks(a), blocks_b = split_into_blocks(b);
+  if (blocks_a.empty() || blocks_b.empty())
+    return result;
+
+  std::vector<std::vector<long double>> lower_bounds =
+      build_min_sparse_table(get_result_lower_bounds(blocks_a, blocks_b, result_size));
+
+  std::vector<std::vector<long double>> scaled_b(blocks_b.size());
+  for (size_t idx = 0; idx < blocks_b.size(); idx++)
+    scaled_b[idx] = scale_block(b, blocks_b[idx]);
+
+  for (const Block &block_a : blocks_a) {
+    std::vector<long double> scaled_a = scale_block(a, block_a);
+    for (size_t idx = 0; idx < blocks_b.size(); idx++) {
+      const Block &block_b = blocks_b[idx];
+      size_t result_begin = block_a.begin + block_b.begin, result_end = block_a.end + block_b.end - 1;
+
+      long double max_contribution =
+          block_a.max + block_b.max + std::log((long double)std::min(scaled_a.size(), scaled_b[idx].size()));
+      if (max_contribution < query_min_sparse_table(lower_bounds, result_begin, result_end) - NEGLIGIBLE_LOG_GAP)
+        continue;
+
+      std::vector<long double> block_result = convolve_scaled(scaled_a, scaled_b[idx]);
+      for (size_t k = 0; k < block_result.size(); k++) {
+        size_t pos = result_begin + k;
+        result[pos] = log_add(result[pos], std::log(block_result[k]) + block_a.max + block_b.max);
+      }
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,11 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <vector>
+
+// convolves two distributions given as log probabilities, result[k] = log(sum_{i + j = k} exp(a[i] + b[j]))
+// both inputs are split into blocks of similar magnitude, large block pairs are convolved with FFT on scaled (non-log)
+// values and small or ill-conditioned ones exactly
+std::vector<long double> convolve_logprobs(const std::vector<long double> &a, const std::vector<long double> &b);
+
+#endif // CONVOLUTION_H
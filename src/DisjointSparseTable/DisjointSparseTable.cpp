@@ -0,0 +1,81 @@
+#include "DisjointSparseTable.hpp"
+#include "../Interval/Section.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+#include <algorithm>
+#include <bit>
+#include <tuple>
+
+template <class T> DisjointSparseTable<T>::DisjointSparseTable() : n(0), max_range(0) {}
+
+template <class T>
+DisjointSparseTable<T>::DisjointSparseTable(DisjointSparseTableOperation operation, T neutral_element,
+                                            const std::vector<T> &values, const MarkovChain &mc, int max_range)
+    : n(values.size()), max_range(max_range), op(operation), neutral_element(neutral_element), markov_chain(mc),
+      values(values) {
+  int levels = n > 1 ? std::bit_width((unsigned)n - 1) + 1 : 1;
+  this->table.assign(levels, {});
+
+  // (level, middle of the block, left half) of every half block that has to be filled, blocks whose right half is
+  // empty are never queried
+  std::vector<std::tuple<int, int, bool>> halves;
+  for (int h = 1; h < levels; h++) {
+    this->table[h].assign(n, neutral_element);
+    for (int mid = 1 << (h - 1); mid < n; mid += 1 << h) {
+      halves.push_back({h, mid, true});
+      halves.push_back({h, mid, false});
+    }
+  }
+
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp taskloop default(shared)
+  for (size_t idx = 0; idx < halves.size(); idx++) {
+    ProfileScope scope(context);
+    auto [h, mid, left] = halves[idx];
+    std::vector<T> &level = this->table[h];
+    int half = 1 << (h - 1);
+    if (left) {
+      level[mid - 1] = this->values[mid - 1];
+      for (int i = mid - 2; i >= mid - std::min(half, max_range); i--)
+        level[i] = this->op(this->values[i], level[i + 1], this->markov_chain);
+    } else {
+      int end = std::min(mid + std::min(half, max_range), n);
+      level[mid] = this->values[mid];
+      for (int i = mid + 1; i < end; i++)
+        level[i] = this->op(level[i - 1], this->values[i], this->markov_chain);
+    }
+  }
+}
+
+template <class T> T DisjointSparseTable<T>::query(int l, int r) {
+  if (l >= r)
+    return this->neutral_element;
+  if (r - l == 1)
+    return this->values[l];
+  if (r - l > this->max_range) {
+    logger.error("Range is longer than the maximal range of the disjoint sparse table.");
+    exit(1);
+  }
+
+  int h = std::bit_width((unsigned)(l ^ (r - 1)));
+  return this->op(this->table[h][l], this->table[h][r - 1], this->markov_chain);
+}
+
+template <class T>
+long double DisjointSparseTable<T>::estimate_size(int n, const std::function<long double(int, int)> &range_cost,
+                                                  int max_range) {
+  long double size = 0;
+  for (int h = 1; (1 << (h - 1)) < n; h++) {
+    int half = 1 << (h - 1);
+    for (int mid = half; mid < n; mid += 1 << h) {
+      for (int i = mid - std::min(half, max_range); i < mid; i++)
+        size += range_cost(i, mid);
+      for (int i = mid; i < std::min(mid + std::min(half, max_range), n); i++)
+        size += range_cost(mid, i + 1);
+    }
+  }
+  return size;
+}
+
+template class DisjointSparseTable<int>;
+template class DisjointSparseTable<Section>;
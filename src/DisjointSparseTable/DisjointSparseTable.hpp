@@ -0,0 +1,40 @@
+#ifndef DISJOINTSPARSETABLE_H
+#define DISJOINTSPARSETABLE_H
+
+#include "../MarkovChain/MarkovChain.hpp"
+
+#include <functional>
+#include <limits>
+#include <vector>
+
+// static range queries with exactly one operation per query, the operation only needs to be associative.
+// level h splits the elements into blocks of size 2^h and stores for every element the combination of it with the
+// rest of its half of the block towards the middle, so [l, r) is the combination of the two entries of the level
+// where l and r - 1 first fall into different halves. takes O(n log n) operations and memory to build.
+// an entry of [l, r) is at most r - l elements long, so if no range is longer than `max_range` the longer entries
+// are skipped, which matters when the cost of the operation grows with the number of combined elements
+template <class T> class DisjointSparseTable {
+public:
+  using DisjointSparseTableOperation = std::function<T(T, T, const MarkovChain &)>;
+
+  DisjointSparseTable();
+  DisjointSparseTable(DisjointSparseTableOperation operation, T neutral_element, const std::vector<T> &values,
+                      const MarkovChain &mc, int max_range = std::numeric_limits<int>::max());
+
+  T query(int l, int r); // returns combined elements from interval [l, r) with the operation provided
+
+  // sum of `range_cost(a, b)` over the ranges [a, b) of all entries a table over n elements would store,
+  // can be used to estimate its memory before building it
+  static long double estimate_size(int n, const std::function<long double(int, int)> &range_cost,
+                                   int max_range = std::numeric_limits<int>::max());
+
+private:
+  int n, max_range;
+  DisjointSparseTableOperation op;
+  T neutral_element;
+  MarkovChain markov_chain;
+  std::vector<T> values;
+  std::vector<std::vector<T>> table;
+};
+
+#endif // DISJOINTSPARSETABLE_H
@@ -4,7 +4,9 @@ const std::map<std::string, Algorithm> algorithmToEnum = {{"naive", Algorithm::N
                                                           {"slow", Algorithm::SLOW},
                                                           {"slow_bad", Algorithm::SLOW_BAD},
                                                           {"fast", Algorithm::FAST},
-                                                          {"fast_bad", Algorithm::FAST_BAD}};
+                                                          {"fast_bad", Algorithm::FAST_BAD},
+                                                          {"sliding", Algorithm::SLIDING},
+                                                          {"sparse", Algorithm::SPARSE}};
 const std::map<std::string, Statistic> statisticToEnum = {{"overlaps", Statistic::OVERLAPS},
                                                           {"bases", Statistic::BASES}};
 const std::map<std::string, Significance> significanceToEnum = {{"enrichment", Significance::ENRICHMENT},
@@ -17,7 +19,9 @@ const std::map<Algorithm, std::string> algorithmToString = {{Algorithm::NAIVE, "
                                                             {Algorithm::SLOW, "slow"},
                                                             {Algorithm::SLOW_BAD, "slow_bad"},
                                                             {Algorithm::FAST, "fast"},
-                                                            {Algorithm::FAST_BAD, "fast_bad"}};
+                                                            {Algorithm::FAST_BAD, "fast_bad"},
+                                                            {Algorithm::SLIDING, "sliding"},
+                                                            {Algorithm::SPARSE, "sparse"}};
 
 const std::map<Significance, std::string> significanceToString = {{Significance::ENRICHMENT, "enrichment"},
                                                                   {Significance::DEPLETION, "depletion"},
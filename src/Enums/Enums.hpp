@@ -4,7 +4,7 @@
 #include <map>
 #include <string>
 
-enum class Algorithm { NAIVE, SLOW_BAD, SLOW, FAST_BAD, FAST };
+enum class Algorithm { NAIVE, SLOW_BAD, SLOW, FAST_BAD, FAST, SLIDING, SPARSE };
 enum class Statistic { OVERLAPS, BASES };
 enum class Significance { ENRICHMENT, DEPLETION, COMBINED };
 
@@ -0,0 +1,114 @@
+#include "Generator.hpp"
+#include "../Interval/ChrDictionary.hpp"
+#include "../Logger/Logger.hpp"
+#include "../ParallelSort/ParallelSort.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <omp.h>
+#include <unordered_map>
+
+// bytes of TSV collected before they are written out
+const size_t TSV_WRITE_BUFFER = 1 << 20;
+
+MarkovChain markov_chain_from_density(long double density, long double mean_length) {
+  if (density <= 0 || density >= 1 || mean_length < 1) {
+    logger.error("Density should be in the range (0, 1) and mean length at least 1.");
+    exit(1);
+  }
+
+  // runs of state 1 end with probability c per base, runs of state 0 with b, and pi_1 = b / (b + c) = density
+  long double c = 1 / mean_length, b = density * c / (1 - density);
+  if (b > 1) {
+    logger.error("Density is too high for the mean length, gaps would be shorter than one base.");
+    exit(1);
+  }
+
+  TransitionMatrix T = {{{{1 - b, b}}, {{c, 1 - c}}}};
+  TransitionMatrix T_MOD = {{{{1 - b, 0}}, {{c, 0}}}};
+  return MarkovChain(T, T_MOD);
+}
+
+std::vector<std::optional<MarkovChain>> fit_markov_chains(const ChrSizesVector &chr_sizes,
+                                                          const std::vector<Interval> &intervals) {
+  std::unordered_map<uint32_t, std::vector<Interval>> intervals_by_chr;
+  for (const Interval &interval : intervals)
+    intervals_by_chr[interval.chr_id].push_back(interval);
+
+  std::vector<std::optional<MarkovChain>> markov_chains(chr_sizes.size());
+  for (size_t chr_idx = 0; chr_idx < chr_sizes.size(); chr_idx++) {
+    auto it = intervals_by_chr.find(ChrDictionary::get_id(chr_sizes[chr_idx].first));
+    if (it != intervals_by_chr.end())
+      markov_chains[chr_idx] = MarkovChain(chr_sizes[chr_idx].second, it->second);
+  }
+  return markov_chains;
+}
+
+std::vector<Interval> generate_chr_intervals(uint32_t chr_id, long long chr_size, const MarkovChain &markov_chain,
+                                             std::mt19937_64 &rng) {
+  TransitionMatrix T = markov_chain.get_T();
+  std::bernoulli_distribution start_state(markov_chain.get_stationary_distribution()[1]);
+  // a run of state s lasts one base and then as many more as there are failures before leaving with T[s][1 - s]
+  std::geometric_distribution<long long> run_length[2] = {std::geometric_distribution<long long>((double)T[0][1]),
+                                                          std::geometric_distribution<long long>((double)T[1][0])};
+
+  std::vector<Interval> intervals;
+  int state = start_state(rng);
+  for (long long pos = 0; pos < chr_size; state = 1 - state) {
+    long long end = std::min(chr_size, pos + 1 + run_length[state](rng));
+    if (state)
+      intervals.push_back({chr_id, pos, end});
+    pos = end;
+  }
+  return intervals;
+}
+
+std::vector<Interval> generate_intervals(const ChrSizesVector &chr_sizes,
+                                         const std::vector<std::optional<MarkovChain>> &markov_chains, uint64_t seed,
+                                         uint32_t track) {
+  std::vector<std::vector<Interval>> intervals_by_chr(chr_sizes.size());
+#pragma omp parallel for schedule(dynamic)
+  for (size_t chr_idx = 0; chr_idx < chr_sizes.size(); chr_idx++) {
+    if (!markov_chains[chr_idx])
+      continue;
+    std::seed_seq seeds = {(uint32_t)seed, (uint32_t)(seed >> 32), track, (uint32_t)chr_idx};
+    std::mt19937_64 rng(seeds);
+    intervals_by_chr[chr_idx] = generate_chr_intervals(ChrDictionary::get_id(chr_sizes[chr_idx].first),
+                                                       chr_sizes[chr_idx].second, *markov_chains[chr_idx], rng);
+  }
+
+  std::vector<Interval> intervals;
+  for (const std::vector<Interval> &chr_intervals : intervals_by_chr)
+    intervals.insert(intervals.end(), chr_intervals.begin(), chr_intervals.end());
+  // runs of state 1 are separated by runs of state 0, so only the order of the chromosomes needs fixing
+  sort_intervals(intervals);
+  return intervals;
+}
+
+void write_intervals_tsv(const std::string &file_path, const std::vector<Interval> &intervals) {
+  std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    logger.error("Failed to open file for writing: " + file_path);
+    exit(1);
+  }
+
+  std::string buffer;
+  for (const Interval &interval : intervals) {
+    buffer += interval.get_chr_name();
+    buffer += '\t';
+    buffer += std::to_string(interval.begin);
+    buffer += '\t';
+    buffer += std::to_string(interval.end);
+    buffer += '\n';
+    if (buffer.size() >= TSV_WRITE_BUFFER) {
+      file.write(buffer.data(), buffer.size());
+      buffer.clear();
+    }
+  }
+  file.write(buffer.data(), buffer.size());
+
+  if (!file) {
+    logger.error("Failed to write intervals into: " + file_path);
+    exit(1);
+  }
+}
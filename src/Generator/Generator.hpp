@@ -0,0 +1,37 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "../Helpers/Helpers.hpp"
+#include "../Interval/Interval.hpp"
+#include "../MarkovChain/MarkovChain.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+// chain whose state 1 covers `density` of the bases, in runs of `mean_length` bases on average
+MarkovChain markov_chain_from_density(long double density, long double mean_length);
+
+// one chain per chromosome of `chr_sizes` fitted to its intervals like the model does for the query, chromosomes
+// without intervals get none
+std::vector<std::optional<MarkovChain>> fit_markov_chains(const ChrSizesVector &chr_sizes,
+                                                          const std::vector<Interval> &intervals);
+
+// samples the chain over `chr_size` bases, starting from its stationary distribution, and returns the runs of state 1.
+// runs are sampled as geometric lengths, so the time is linear in the number of runs and not in the number of bases
+std::vector<Interval> generate_chr_intervals(uint32_t chr_id, long long chr_size, const MarkovChain &markov_chain,
+                                             std::mt19937_64 &rng);
+
+// intervals of every chromosome in `chr_sizes`, sampled from the chain of the same index, chromosomes without a chain
+// stay empty. every chromosome has its own generator derived from `seed`, `track` and its index, so the output depends
+// only on these and not on the number of threads, and tracks sampled with the same seed are independent.
+// the result is sorted and merged
+std::vector<Interval> generate_intervals(const ChrSizesVector &chr_sizes,
+                                         const std::vector<std::optional<MarkovChain>> &markov_chains, uint64_t seed,
+                                         uint32_t track);
+
+void write_intervals_tsv(const std::string &file_path, const std::vector<Interval> &intervals);
+
+#endif // GENERATOR_H
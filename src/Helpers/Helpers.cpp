@@ -1,17 +1,25 @@
 #include "Helpers.hpp"
+#include "../Convolution/Convolution.hpp"
+#include "../Interval/ChrDictionary.hpp"
 #include "../Interval/Interval.hpp"
+#include "../Interval/IntervalsView.hpp"
 #include "../Interval/Section.hpp"
+#include "../IntervalsLoader/IntervalsCache.hpp"
+#include "../IntervalsLoader/IntervalsLoader.hpp"
 #include "../Logger/Logger.hpp"
 #include "../Model/Model.hpp"
+#include "../ParallelSort/ParallelSort.hpp"
+#include "../Profiler/Profiler.hpp"
 #include <algorithm>
 #include <array>
 #include <cmath>
-#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -39,47 +47,34 @@ std::vector<std::string> split_string(std::string str, char delimeter, size_t ex
 
 // expects {chr_name} {begin} {end}
 Interval parse_intervals_line(std::string line) {
-  size_t exp_elem_cnt = 3;
-  std::vector<std::string> vals = split_string(line, '\t', exp_elem_cnt);
-
-  if (vals.size() != exp_elem_cnt) {
-    logger.error("Invalid line format on line: " + line + ". Should be {chr_name} {begin} {end}.");
+  std::string_view chr_name;
+  long long begin, end;
+  std::string error;
+  if (!parse_interval_fields(line, chr_name, begin, end, error)) {
+    logger.error(error);
     exit(1);
   }
 
-  return Interval(vals[0], std::stoll(vals[1]), std::stoll(vals[2]));
+  return Interval(std::string(chr_name), begin, end);
 }
 
 std::vector<Interval> load_intervals(const std::string &file_path, bool is_closed) {
-  std::vector<Interval> intervals;
-
-  std::ifstream input_file(file_path);
+  MappedFile input_file(file_path);
   if (!input_file.is_open()) {
     logger.error("Failed to open intervals file: " + file_path);
     exit(1);
   }
 
-  std::string line;
-  while (std::getline(input_file, line)) {
-    Interval interval = parse_intervals_line(line);
-    if (is_closed)
-      interval.end--;
-
-    if (interval.begin >= interval.end) {
-      logger.error("Begin should be strictly smaller than end in stated "
-                   "intervals.");
-      exit(1);
-    }
-
-    if (interval.begin < 0 || interval.end < 0) {
-      logger.error("Interval bounds should be non-negative.");
-      exit(1);
-    }
+  // files written by `emcdp convert` are recognized by their magic bytes, they are already half open
+  if (is_intervals_cache(input_file.data(), input_file.size()))
+    return read_intervals_cache(input_file.data(), input_file.size(), file_path);
 
-    intervals.push_back(interval);
+  if (is_gzip(input_file.data(), input_file.size())) {
+    GzipReader reader(input_file.data(), input_file.size(), file_path);
+    return parse_intervals_stream(reader, is_closed);
   }
 
-  return intervals;
+  return parse_intervals_buffer(input_file.data(), input_file.size(), is_closed);
 }
 
 // assumes args.check_invalid_args has already been run
@@ -90,11 +85,11 @@ std::vector<Interval> load_windows(Args &args, std::unordered_map<std::string, l
     std::vector<std::pair<std::string, long long>> chr_sizes_vec(chr_sizes.begin(), chr_sizes.end());
     std::sort(chr_sizes_vec.begin(), chr_sizes_vec.end());
     for (std::pair<std::string, long long> chr : chr_sizes) {
-      std::string chr_name = chr.first;
+      uint32_t chr_id = ChrDictionary::get_id(chr.first);
       long long chr_size = chr.second;
       long long l = 0, r = std::min(chr_size, args.windows_size);
       while (1) {
-        windows.push_back({chr_name, l, r});
+        windows.push_back({chr_id, l, r});
         if (r >= chr_size) {
           break;
         }
@@ -121,12 +116,13 @@ std::vector<Interval> load_windows(Args &args, std::unordered_map<std::string, l
 ChrSizesMap load_chr_sizes(const std::string &file_path) {
   ChrSizesMap chr_sizes;
 
-  std::ifstream input_file(file_path);
-  if (!input_file.is_open()) {
+  std::string content;
+  if (!read_whole_file(file_path, content)) {
     logger.error("Failed to open chromosome sizes file: " + file_path);
     exit(1);
   }
 
+  std::istringstream input_file(content);
   std::string line;
   while (getline(input_file, line)) {
     std::vector<std::string> vals = split_string(line, '\t', 2);
@@ -146,6 +142,14 @@ ChrSizesMap load_chr_sizes(const std::string &file_path) {
     chr_sizes[chr_name] = chr_size;
   }
 
+  // chromosomes are added to the dictionary in sorted order, so their ids follow the order of their names
+  std::vector<std::string> chr_names;
+  for (const auto &p : chr_sizes)
+    chr_names.push_back(p.first);
+  std::sort(chr_names.begin(), chr_names.end());
+  for (const std::string &chr_name : chr_names)
+    ChrDictionary::get_id(chr_name);
+
   return chr_sizes;
 }
 
@@ -160,10 +164,14 @@ load_chr_names_from_chr_sizes(const std::unordered_map<std::string, long long> &
 
 std::vector<Interval> filter_intervals_by_chr_name(std::vector<Interval> intervals,
                                                    std::unordered_set<std::string> chr_names) {
+  std::unordered_set<uint32_t> chr_ids;
+  for (const std::string &chr_name : chr_names)
+    chr_ids.insert(ChrDictionary::get_id(chr_name));
+
   std::vector<Interval> new_intervals;
 
   for (Interval interval : intervals) {
-    if (chr_names.count(interval.chr_name)) {
+    if (chr_ids.count(interval.chr_id)) {
       new_intervals.push_back(interval);
     }
   }
@@ -176,13 +184,13 @@ std::vector<Interval> merge_non_disjoint_intervals(std::vector<Interval> interva
     return intervals;
   }
 
-  std::sort(intervals.begin(), intervals.end());
+  sort_intervals(intervals);
 
   std::vector<Interval> new_intervals;
   Interval cur_interval = intervals[0];
   for (size_t interval_idx = 1; interval_idx < intervals.size(); interval_idx++) {
     Interval new_interval = intervals[interval_idx];
-    if (cur_interval.chr_name != new_interval.chr_name || cur_interval.end < new_interval.begin) {
+    if (cur_interval.chr_id != new_interval.chr_id || cur_interval.end < new_interval.begin) {
       new_intervals.push_back(cur_interval);
       cur_interval = new_interval;
       continue;
@@ -210,22 +218,51 @@ std::vector<Interval> remove_empty_intervals(std::vector<Interval> intervals) {
   return new_intervals;
 }
 
-std::vector<std::string> get_sorted_chr_names_from_intervals(std::vector<Interval> intervals) {
-  std::vector<std::string> chr_names;
+void preprocess_intervals(std::vector<Interval> &intervals, const ChrSizesMap &chr_sizes, bool merge) {
+  // chromosome ids are dense, so a flag per id is enough to filter
+  std::vector<char> is_known_chr(ChrDictionary::size());
+  for (const auto &p : chr_sizes)
+    is_known_chr[ChrDictionary::get_id(p.first)] = true;
+
+  // filtering and dropping empty intervals first makes the sort cheaper
+  auto kept_end = std::remove_if(intervals.begin(), intervals.end(), [&is_known_chr](const Interval &interval) {
+    return interval.chr_id >= is_known_chr.size() || !is_known_chr[interval.chr_id] || interval.begin >= interval.end;
+  });
+  intervals.erase(kept_end, intervals.end());
+
+  if (!std::is_sorted(intervals.begin(), intervals.end()))
+    sort_intervals(intervals);
+
+  if (!merge || intervals.empty())
+    return;
+
+  size_t merged_idx = 0;
+  for (size_t idx = 1; idx < intervals.size(); idx++) {
+    Interval &cur_interval = intervals[merged_idx];
+    if (cur_interval.chr_id != intervals[idx].chr_id || cur_interval.end < intervals[idx].begin)
+      intervals[++merged_idx] = intervals[idx];
+    else
+      cur_interval.end = std::max(cur_interval.end, intervals[idx].end);
+  }
+  intervals.resize(merged_idx + 1);
+}
+
+std::vector<uint32_t> get_sorted_chr_ids_from_intervals(std::vector<Interval> intervals) {
+  std::vector<uint32_t> chr_ids;
 
   if (intervals.empty()) {
-    return chr_names;
+    return chr_ids;
   }
 
   sort(intervals.begin(), intervals.end());
-  chr_names.push_back(intervals[0].chr_name);
+  chr_ids.push_back(intervals[0].chr_id);
   for (Interval interval : intervals) {
-    if (interval.chr_name != intervals.back().chr_name) {
-      chr_names.push_back(interval.chr_name);
+    if (interval.chr_id != chr_ids.back()) {
+      chr_ids.push_back(interval.chr_id);
     }
   }
 
-  return chr_names;
+  return chr_ids;
 }
 
 template <typename T> void extend(std::vector<T> &self, const std::vector<T> &other) {
@@ -235,83 +272,74 @@ template <typename T> void extend(std::vector<T> &self, const std::vector<T> &ot
   }
 }
 
-// assuming intervals are sorted
-long long count_overlaps_single_chr(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals) {
-  long long overlap_count = 0;
-  bool is_ref_interval_open = false, is_query_interval_open = false, is_current_ref_interval_counted = false;
-
-  std::vector<std::vector<long long>> events;
-  for (Interval interval : ref_intervals) {
-    events.push_back({interval.begin, 0, 1});
-    events.push_back({interval.end, 0, 0});
-  }
-  for (Interval interval : query_intervals) {
-    events.push_back({interval.begin, 1, 1});
-    events.push_back({interval.end, 1, 0});
-  }
-  sort(events.begin(), events.end());
-
-  long long last_pos = -1;
-  for (std::vector<long long> event : events) {
-    long long pos = event[0];
-    bool is_query = event[1], is_end = !event[2];
-    if (last_pos < pos) {
-      last_pos = pos;
-      if (is_ref_interval_open && is_query_interval_open && !is_current_ref_interval_counted) {
-        overlap_count++;
-        is_current_ref_interval_counted = true;
-      }
-    }
-
-    if (!is_query && !is_end) {
-      is_ref_interval_open = true;
-      is_current_ref_interval_counted = false;
-    }
-    if (!is_query && is_end) {
-      is_ref_interval_open = false;
-    }
-    if (is_query && !is_end) {
-      is_query_interval_open = true;
-    }
-    if (is_query && is_end) {
-      is_query_interval_open = false;
-    }
-  }
+// assuming intervals are sorted and non-overlapping
+long long count_overlaps_single_chr(const std::vector<Interval> &ref_intervals,
+                                    const std::vector<Interval> &query_intervals) {
+  return IntervalsView::count_overlaps(IntervalsView(std::make_shared<const IntervalColumns>(ref_intervals)),
+                                       IntervalsView(std::make_shared<const IntervalColumns>(query_intervals)));
+}
 
-  return overlap_count;
+// sorted input is used as it is, anything else is sorted in `storage`
+static const std::vector<Interval> &sorted_intervals(const std::vector<Interval> &intervals,
+                                                     std::vector<Interval> &storage) {
+  if (std::is_sorted(intervals.begin(), intervals.end()))
+    return intervals;
+  storage = intervals;
+  sort_intervals(storage);
+  return storage;
 }
 
-long long count_overlaps(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals) {
-  std::sort(ref_intervals.begin(), ref_intervals.end());
-  std::sort(query_intervals.begin(), query_intervals.end());
-
-  std::vector<std::string> chr_names, ref_chr_names = get_sorted_chr_names_from_intervals(ref_intervals),
-                                      query_chr_names = get_sorted_chr_names_from_intervals(query_intervals);
-  extend(chr_names, ref_chr_names);
-  extend(chr_names, query_chr_names);
-
-  auto get_chr_intervals = [](std::vector<Interval> &intervals, int &idx, std::string chr_name) {
-    std::vector<Interval> chr_intervals;
-    for (; idx < (int)intervals.size() && intervals[idx].chr_name <= chr_name; idx++)
-      if (intervals[idx].chr_name == chr_name)
-        chr_intervals.push_back(intervals[idx]);
-    return chr_intervals;
-  };
+long long count_overlaps(const std::vector<Interval> &ref_intervals, const std::vector<Interval> &query_intervals) {
+  std::vector<Interval> ref_storage, query_storage;
+  const std::vector<Interval> &ref = sorted_intervals(ref_intervals, ref_storage),
+                              &query = sorted_intervals(query_intervals, query_storage);
 
-  int ref_idx = 0, query_idx = 0;
   long long total_overlap_count = 0;
-  for (std::string chr_name : chr_names) {
-    std::vector<Interval> chr_ref_intervals = get_chr_intervals(ref_intervals, ref_idx, chr_name),
-                          chr_query_intervals = get_chr_intervals(query_intervals, query_idx, chr_name);
+  for (size_t ref_idx = 0, query_idx = 0; ref_idx < ref.size();) {
+    uint32_t chr_id = ref[ref_idx].chr_id;
+    size_t ref_end = ref_idx;
+    while (ref_end < ref.size() && ref[ref_end].chr_id == chr_id)
+      ref_end++;
+    while (query_idx < query.size() && query[query_idx].chr_id < chr_id)
+      query_idx++;
+    size_t query_end = query_idx;
+    while (query_end < query.size() && query[query_end].chr_id == chr_id)
+      query_end++;
+
+    if (query_end > query_idx)
+      total_overlap_count += IntervalsView::count_overlaps(
+          IntervalsView(std::make_shared<const IntervalColumns>(ref.begin() + ref_idx, ref.begin() + ref_end)),
+          IntervalsView(std::make_shared<const IntervalColumns>(query.begin() + query_idx, query.begin() + query_end)));
+
+    ref_idx = ref_end;
+    query_idx = query_end;
+  }
 
-    if (chr_ref_intervals.empty() || chr_query_intervals.empty())
-      continue;
+  return total_overlap_count;
+}
+
+long long count_overlapping_bases(const std::vector<Interval> &ref_intervals,
+                                  const std::vector<Interval> &query_intervals) {
+  std::vector<Interval> ref_storage, query_storage;
+  const std::vector<Interval> &ref = sorted_intervals(ref_intervals, ref_storage),
+                              &query = sorted_intervals(query_intervals, query_storage);
+
+  long long total_base_count = 0;
+  size_t query_idx = 0;
+  for (const Interval &ref_interval : ref) {
+    // query intervals ending before this reference interval end before all the following ones too
+    while (query_idx < query.size() && (query[query_idx].chr_id < ref_interval.chr_id ||
+                                        (query[query_idx].chr_id == ref_interval.chr_id &&
+                                         query[query_idx].end <= ref_interval.begin)))
+      query_idx++;
 
-    long long chr_overlap_count = count_overlaps_single_chr(chr_ref_intervals, chr_query_intervals);
-    total_overlap_count += chr_overlap_count;
+    for (size_t idx = query_idx;
+         idx < query.size() && query[idx].chr_id == ref_interval.chr_id && query[idx].begin < ref_interval.end; idx++)
+      total_base_count +=
+          std::min(query[idx].end, ref_interval.end) - std::max(query[idx].begin, ref_interval.begin);
   }
 
-  return total_overlap_count;
+  return total_base_count;
 }
 
 ChrSizesVector chr_sizes_map_to_array(ChrSizesMap &chr_sizes_map) {
@@ -459,6 +487,33 @@ long double logsumexp(const std::vector<long double> &values) {
   return max_value + log(sum);
 }
 
+// below this total support size the two halves of a product tree node are combined in the current task
+const size_t PRODUCT_TREE_TASK_CUTOFF = 1 << 14;
+
+// convolves levels[lo, hi) as a balanced binary tree, the two halves of each node are computed as separate tasks
+static std::vector<long double>
+joint_logprobs_product_tree(const std::vector<const std::vector<long double> *> &levels, size_t lo, size_t hi) {
+  if (hi - lo == 1)
+    return *levels[lo];
+
+  size_t total_size = 0;
+  for (size_t idx = lo; idx < hi; idx++)
+    total_size += levels[idx]->size();
+
+  size_t mid = (lo + hi) / 2;
+  std::vector<long double> left, right;
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp task shared(left) if (total_size > PRODUCT_TREE_TASK_CUTOFF)
+  {
+    ProfileScope scope(context);
+    left = joint_logprobs_product_tree(levels, lo, mid);
+  }
+  right = joint_logprobs_product_tree(levels, mid, hi);
+#pragma omp taskwait
+
+  return convolve_logprobs(left, right);
+}
+
 std::vector<long double> joint_logprobs(const std::vector<std::vector<long double>> &probs_by_chr) {
   if (probs_by_chr.size() == 0) {
     logger.error("p-values should have at least one level!.");
@@ -476,33 +531,29 @@ std::vector<long double> joint_logprobs(const std::vector<std::vector<long doubl
     return probs_by_chr[0];
   }
 
-  long long max_k = 0;
-  for (size_t idx = 0; idx < probs_by_chr.size(); idx++)
-    max_k += probs_by_chr[idx].size() - 1;
+  if (probs_by_chr.size() == 2)
+    return convolve_logprobs(probs_by_chr[0], probs_by_chr[1]);
 
-  const long double ld_inf = std::numeric_limits<long double>::infinity();
+  // levels sorted by size, so that neighbouring subtrees have similar supports and every convolution is
+  // proportional to the sizes of its inputs instead of the size of the whole result
+  std::vector<const std::vector<long double> *> levels;
+  for (const std::vector<long double> &level : probs_by_chr)
+    levels.push_back(&level);
+  std::stable_sort(levels.begin(), levels.end(),
+                   [](const std::vector<long double> *a, const std::vector<long double> *b) {
+                     return a->size() < b->size();
+                   });
 
-  std::vector<long double> prev_row(max_k + 1, -ld_inf);
-  for (size_t pos = 0; pos < probs_by_chr[0].size(); pos++)
-    prev_row[pos] = probs_by_chr[0][pos];
-
-  std::vector<long double> next_row(max_k + 1, -ld_inf);
-
-  std::vector<long double> accum;
-  for (std::vector<long double> level :
-       std::vector<std::vector<long double>>(probs_by_chr.begin() + 1, probs_by_chr.end())) {
-    for (long long k = 0; k <= max_k; k++) {
-      long long accum_size = std::min(k + 1, (long long)level.size());
-      accum.resize(accum_size);
-      for (int j = 0; j < accum_size; j++)
-        accum[j] = level[j] + prev_row[k - j];
-      next_row[k] = logsumexp(accum);
-      accum.clear();
-    }
-    prev_row = next_row;
+  std::vector<long double> result;
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp parallel
+#pragma omp single
+  {
+    ProfileScope scope(context);
+    result = joint_logprobs_product_tree(levels, 0, levels.size());
   }
 
-  return next_row;
+  return result;
 }
 
 MultiProbs joint_logprobs(const MultiProbs &probs1, const MultiProbs &probs2) {
@@ -533,8 +584,8 @@ MultiProbs joint_logprobs(const MultiProbs &probs1, const MultiProbs &probs2) {
 
   for (int i : {0, 1}) {
     for (int j : {0, 1}) {
-      std::vector<long double> midpoint_0 = joint_logprobs({probs1[i][0], probs2[0][j]}),
-                               midpoint_1 = joint_logprobs({probs1[i][1], probs2[1][j]});
+      std::vector<long double> midpoint_0 = convolve_logprobs(probs1[i][0], probs2[0][j]),
+                               midpoint_1 = convolve_logprobs(probs1[i][1], probs2[1][j]);
 
       if (midpoint_0.size() != midpoint_1.size()) {
         logger.error("combined probs with different intermediary states do not "
@@ -730,12 +781,13 @@ std::string to_string(const long double &val) {
 }
 
 Interval slice_interval_by_window(const Interval &window, const Interval &interval) {
-  return {interval.chr_name, std::max(window.begin, interval.begin), std::min(window.end, interval.end)};
+  return {interval.chr_id, std::max(window.begin, interval.begin), std::min(window.end, interval.end)};
 }
 
 bool are_intervals_non_overlapping(const std::vector<Interval> &intervals) {
   std::vector<Interval> sortedIntervals = intervals;
-  std::sort(sortedIntervals.begin(), sortedIntervals.end());
+  if (!std::is_sorted(sortedIntervals.begin(), sortedIntervals.end()))
+    sort_intervals(sortedIntervals);
   for (size_t idx = 1; idx < sortedIntervals.size(); idx++) {
     if (sortedIntervals[idx].begin < sortedIntervals[idx - 1].end) {
       return false;
@@ -752,7 +804,7 @@ WindowSectionSplitResult split_windows_into_non_overlapping_sections(const std::
     return {};
   }
 
-  std::string chr_name = windows[0].chr_name;
+  uint32_t chr_id = windows[0].chr_id;
 
   const int REF_INTERVAL = 0;
   const int QUERY_INTERVAL = 1;
@@ -784,15 +836,12 @@ WindowSectionSplitResult split_windows_into_non_overlapping_sections(const std::
     events[buf + ((idx << 1) | 1)] = {query_interval.end, 1, idx, QUERY_INTERVAL};
   }
 
-  std::sort(events.begin(), events.end(), [](const Event &e1, const Event &e2) {
-    if (e1.pos == e2.pos) {
-      if (e1.type == e2.type)
-        return e1.type != WINDOW ? e1.end < e2.end : e1.end > e2.end;
-      if (e1.type == WINDOW || e2.type == WINDOW) {
-        return e1.end == e2.end ? e1.type < e2.type : e1.end > e2.end;
-      }
-    }
-    return e1.pos < e2.pos;
+  // at the same position interval ends go first, then window ends, interval starts and window starts, ties are broken
+  // by type and index so that the order doesn't depend on the input order
+  radix_sort(events, [](const Event &event) {
+    uint64_t rank = event.type == WINDOW ? (event.end ? 1 : 3) : (event.end ? 0 : 2);
+    return ((unsigned __int128)position_key(event.pos) << 64) | (rank << 62) | ((uint64_t)event.type << 60) |
+           event.idx;
   });
 
   std::vector<Interval> spans(windows.size());
@@ -808,14 +857,14 @@ WindowSectionSplitResult split_windows_into_non_overlapping_sections(const std::
       if (!event.end) {
         currently_opened_ref_interval = current_ref_interval;
       } else {
-        currently_opened_ref_interval = Interval("", -1, -1);
+        currently_opened_ref_interval = Interval(chr_id, -1, -1);
       }
     } else if (event.type == QUERY_INTERVAL) {
       Interval current_query_interval = query_intervals[event.idx];
       if (!event.end) {
         currently_opened_query_interval = current_query_interval;
       } else {
-        currently_opened_query_interval = Interval("", -1, -1);
+        currently_opened_query_interval = Interval(chr_id, -1, -1);
       }
     } else {
       if (opened > 0 && section_start != -1 && event.pos != last_pos) {
@@ -832,7 +881,7 @@ WindowSectionSplitResult split_windows_into_non_overlapping_sections(const std::
                                              : section_start;
         long long query_interval_end =
             currently_opened_query_interval.length() != 0 ? currently_opened_query_interval.get_end() : section_end;
-        sections.push_back(Section(chr_name, section_start, section_end, ref_interval_begin < section_start,
+        sections.push_back(Section(chr_id, section_start, section_end, ref_interval_begin < section_start,
                                    section_end < ref_interval_end, query_interval_begin < section_start,
                                    section_end < query_interval_end));
       }
@@ -846,7 +895,7 @@ WindowSectionSplitResult split_windows_into_non_overlapping_sections(const std::
         spans[event.idx].begin = sections.size();
       } else {
         opened--;
-        spans[event.idx].chr_name = chr_name;
+        spans[event.idx].chr_id = chr_id;
         spans[event.idx].end = sections.size();
       }
 
@@ -916,32 +965,24 @@ void print_multiprobs(const MultiProbs &probs) {
 }
 
 Section join_sections(const Section &section1, const Section &section2, const MarkovChain &markov_chain) {
-  SectionProbs probs1 = section1.get_probs(), probs2 = section2.get_probs();
-  std::vector<Interval> ref_ints1 = section1.get_ref_intervals(), ref_ints2 = section2.get_ref_intervals();
-  std::vector<Interval> query_ints1 = section1.get_query_intervals(), query_ints2 = section2.get_query_intervals();
+  profiler.count(Counter::JOINS, 1);
+  const SectionProbs &probs1 = section1.get_probs(), &probs2 = section2.get_probs();
+  const IntervalsView &ref_ints1 = section1.get_ref_intervals(), &ref_ints2 = section2.get_ref_intervals();
+  const IntervalsView &query_ints1 = section1.get_query_intervals(), &query_ints2 = section2.get_query_intervals();
 
   bool ref_overflows = section1.get_last_ref_interval_intersected() && section2.get_first_ref_interval_intersected();
-  bool query_overflows =
-      section1.get_last_query_interval_intersected() && section2.get_first_query_interval_intersected();
   MultiProbs middle_probs;
-  std::vector<Interval> ref_intervals, query_intervals;
+  std::vector<Interval> ref_intervals;
   if (ref_overflows) {
     Interval last_ref_section1 = ref_ints1.back();
     Interval first_ref_section2 = ref_ints2.front();
     ref_intervals = {
-        Interval(last_ref_section1.get_chr_name(), last_ref_section1.get_begin(), first_ref_section2.get_end())};
+        Interval(last_ref_section1.get_chr_id(), last_ref_section1.get_begin(), first_ref_section2.get_end())};
     long long new_start = last_ref_section1.get_begin();
     middle_probs =
         Model::eval_probs_single_chr_direct_new(ref_intervals, new_start, first_ref_section2.get_end(), markov_chain);
   }
 
-  if (query_overflows) {
-    Interval last_query_section1 = query_ints1.back();
-    Interval first_query_section2 = query_ints2.front();
-    query_intervals = {
-        Interval(last_query_section1.get_chr_name(), last_query_section1.get_begin(), first_query_section2.get_end())};
-  }
-
   bool should_calculate_middle_probs = !ref_ints1.empty() && !ref_ints2.empty() &&
                                        ref_ints1.back().get_begin() != section1.get_begin() &&
                                        ref_ints2.front().get_end() != section2.get_end();
@@ -987,26 +1028,11 @@ Section join_sections(const Section &section1, const Section &section2, const Ma
     new_overlap_count--;
   }
 
-  std::vector<Interval> new_ref_intervals = ref_ints1;
-  std::vector<Interval> new_query_intervals = query_ints1;
-  if (!ref_overflows) {
-    new_ref_intervals.insert(new_ref_intervals.end(), ref_ints2.begin(), ref_ints2.end());
-  } else {
-    new_ref_intervals.pop_back();
-    new_ref_intervals.push_back(ref_intervals[0]);
-    new_ref_intervals.insert(new_ref_intervals.end(), ref_ints2.begin() + (!ref_ints2.empty()), ref_ints2.end());
-  }
-
-  if (!query_overflows) {
-    new_query_intervals.insert(new_query_intervals.end(), query_ints2.begin(), query_ints2.end());
-  } else {
-    new_query_intervals.pop_back();
-    new_query_intervals.push_back(query_intervals[0]);
-    new_query_intervals.insert(new_query_intervals.end(), query_ints2.begin() + (!query_ints2.empty()),
-                               query_ints2.end());
-  }
+  // an interval going over the border is the same interval in both views, so the joined view has it once
+  IntervalsView new_ref_intervals = IntervalsView::join(ref_ints1, ref_ints2);
+  IntervalsView new_query_intervals = IntervalsView::join(query_ints1, query_ints2);
 
-  Section merged_section(section1.get_chr_name(), section1.get_begin(), section2.get_end(),
+  Section merged_section(section1.get_chr_id(), section1.get_begin(), section2.get_end(),
                          section1.get_first_ref_interval_intersected(), section2.get_last_ref_interval_intersected(),
                          section1.get_first_query_interval_intersected(),
                          section2.get_last_query_interval_intersected(), new_ref_intervals, new_query_intervals);
@@ -1039,7 +1065,7 @@ std::vector<Interval> split_intervals_into_ones(const std::vector<Interval> &int
 
   for (Interval interval : intervals) {
     for (long long pos = interval.get_begin(); pos < interval.get_end(); pos++) {
-      new_intervals.push_back(Interval(interval.get_chr_name(), pos, pos + 1));
+      new_intervals.push_back(Interval(interval.get_chr_id(), pos, pos + 1));
     }
   }
 
@@ -1047,32 +1073,24 @@ std::vector<Interval> split_intervals_into_ones(const std::vector<Interval> &int
 }
 
 Section join_sections_new(const Section &section1, const Section &section2, const MarkovChain &markov_chain) {
-  SectionProbs probs1 = section1.get_probs(), probs2 = section2.get_probs();
-  std::vector<Interval> ref_ints1 = section1.get_ref_intervals(), ref_ints2 = section2.get_ref_intervals();
-  std::vector<Interval> query_ints1 = section1.get_query_intervals(), query_ints2 = section2.get_query_intervals();
+  profiler.count(Counter::JOINS, 1);
+  const SectionProbs &probs1 = section1.get_probs(), &probs2 = section2.get_probs();
+  const IntervalsView &ref_ints1 = section1.get_ref_intervals(), &ref_ints2 = section2.get_ref_intervals();
+  const IntervalsView &query_ints1 = section1.get_query_intervals(), &query_ints2 = section2.get_query_intervals();
 
   bool ref_overflows = !ref_ints1.empty() && section1.get_last_ref_interval_intersected() && !ref_ints2.empty() &&
                        section2.get_first_ref_interval_intersected();
-  bool query_overflows = !query_ints1.empty() && section1.get_last_query_interval_intersected() &&
-                         !query_ints2.empty() && section2.get_first_query_interval_intersected();
   MultiProbs middle_probs;
-  std::vector<Interval> ref_intervals, query_intervals;
+  std::vector<Interval> ref_intervals;
   if (ref_overflows) {
     Interval last_ref_section1 = ref_ints1.back();
     Interval first_ref_section2 = ref_ints2.front();
     ref_intervals = {
-        Interval(last_ref_section1.get_chr_name(), last_ref_section1.get_begin(), first_ref_section2.get_end())};
+        Interval(last_ref_section1.get_chr_id(), last_ref_section1.get_begin(), first_ref_section2.get_end())};
     middle_probs = Model::eval_probs_single_chr_direct_new(ref_intervals, last_ref_section1.get_begin(),
                                                            first_ref_section2.get_end(), markov_chain);
   }
 
-  if (query_overflows) {
-    Interval last_query_section1 = query_ints1.back();
-    Interval first_query_section2 = query_ints2.front();
-    query_intervals = {
-        Interval(last_query_section1.get_chr_name(), last_query_section1.get_begin(), first_query_section2.get_end())};
-  }
-
   bool should_calculate_middle_probs = !ref_ints1.empty() && !ref_ints2.empty() &&
                                        ref_ints1.back().get_begin() != section1.get_begin() &&
                                        ref_ints2.front().get_end() != section2.get_end();
@@ -1103,26 +1121,11 @@ Section join_sections_new(const Section &section1, const Section &section2, cons
     new_overlap_count--;
   }
 
-  std::vector<Interval> new_ref_intervals = ref_ints1;
-  std::vector<Interval> new_query_intervals = query_ints1;
-  if (!ref_overflows) {
-    new_ref_intervals.insert(new_ref_intervals.end(), ref_ints2.begin(), ref_ints2.end());
-  } else {
-    new_ref_intervals.pop_back();
-    new_ref_intervals.push_back(ref_intervals[0]);
-    new_ref_intervals.insert(new_ref_intervals.end(), ref_ints2.begin() + (!ref_ints2.empty()), ref_ints2.end());
-  }
-
-  if (!query_overflows) {
-    new_query_intervals.insert(new_query_intervals.end(), query_ints2.begin(), query_ints2.end());
-  } else {
-    new_query_intervals.pop_back();
-    new_query_intervals.push_back(query_intervals[0]);
-    new_query_intervals.insert(new_query_intervals.end(), query_ints2.begin() + (!query_ints2.empty()),
-                               query_ints2.end());
-  }
+  // an interval going over the border is the same interval in both views, so the joined view has it once
+  IntervalsView new_ref_intervals = IntervalsView::join(ref_ints1, ref_ints2);
+  IntervalsView new_query_intervals = IntervalsView::join(query_ints1, query_ints2);
 
-  Section merged_section(section1.get_chr_name(), section1.get_begin(), section2.get_end(),
+  Section merged_section(section1.get_chr_id(), section1.get_begin(), section2.get_end(),
                          section1.get_first_ref_interval_intersected(), section2.get_last_ref_interval_intersected(),
                          section1.get_first_query_interval_intersected(),
                          section2.get_last_query_interval_intersected(), new_ref_intervals, new_query_intervals);
@@ -31,11 +31,21 @@ std::vector<Interval> merge_non_disjoint_intervals(std::vector<Interval> interva
 
 std::vector<Interval> remove_empty_intervals(std::vector<Interval> intervals);
 
-long long count_overlaps(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals);
+// filters out intervals on chromosomes missing from chr_sizes, sorts, drops empty intervals and, if `merge` is set,
+// merges overlapping and touching ones. all in place and in a single pass after the sort, which is skipped for sorted
+// input
+void preprocess_intervals(std::vector<Interval> &intervals, const ChrSizesMap &chr_sizes, bool merge = true);
 
-long long count_overlaps_single_chr(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals);
+long long count_overlaps(const std::vector<Interval> &ref_intervals, const std::vector<Interval> &query_intervals);
 
-std::vector<std::string> get_sorted_chr_names_from_intervals(std::vector<Interval> intervals);
+long long count_overlaps_single_chr(const std::vector<Interval> &ref_intervals,
+                                    const std::vector<Interval> &query_intervals);
+
+// number of reference bases covered by the query, both sets should be merged
+long long count_overlapping_bases(const std::vector<Interval> &ref_intervals,
+                                  const std::vector<Interval> &query_intervals);
+
+std::vector<uint32_t> get_sorted_chr_ids_from_intervals(std::vector<Interval> intervals);
 
 ChrSizesVector chr_sizes_map_to_array(std::unordered_map<std::string, long long> &chr_sizes);
 
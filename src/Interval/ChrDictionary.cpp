@@ -0,0 +1,43 @@
+#include "ChrDictionary.hpp"
+#include "../Logger/Logger.hpp"
+
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+// names are kept in a deque so references returned by get_name stay valid when new names are added
+static std::mutex dictionary_mutex;
+static std::deque<std::string> names = {""};
+static std::unordered_map<std::string, uint32_t> ids = {{"", 0}};
+
+uint32_t ChrDictionary::get_id(const std::string &chr_name) {
+  std::lock_guard<std::mutex> lock(dictionary_mutex);
+  auto it = ids.find(chr_name);
+  if (it != ids.end())
+    return it->second;
+
+  if (names.size() > std::numeric_limits<uint32_t>::max()) {
+    logger.error("Too many distinct chromosome names.");
+    exit(1);
+  }
+
+  uint32_t chr_id = names.size();
+  names.push_back(chr_name);
+  ids[chr_name] = chr_id;
+  return chr_id;
+}
+
+const std::string &ChrDictionary::get_name(uint32_t chr_id) {
+  std::lock_guard<std::mutex> lock(dictionary_mutex);
+  if (chr_id >= names.size()) {
+    logger.error("Unknown chromosome id: " + std::to_string(chr_id));
+    exit(1);
+  }
+  return names[chr_id];
+}
+
+size_t ChrDictionary::size() {
+  std::lock_guard<std::mutex> lock(dictionary_mutex);
+  return names.size();
+}
@@ -0,0 +1,17 @@
+#ifndef CHRDICTIONARY_H
+#define CHRDICTIONARY_H
+
+#include <cstdint>
+#include <string>
+
+// process-wide dictionary of chromosome names, intervals keep only the 32-bit id of their chromosome and names are
+// looked up when reading or writing files. the empty name always has id 0, so default intervals keep their old meaning
+class ChrDictionary {
+public:
+  // id of the chromosome, the name is added if it is not known yet
+  static uint32_t get_id(const std::string &chr_name);
+  static const std::string &get_name(uint32_t chr_id);
+  static size_t size();
+};
+
+#endif // CHRDICTIONARY_H
@@ -1,37 +1,40 @@
 #include "Interval.hpp"
+#include "ChrDictionary.hpp"
 #include <string>
 
-Interval::Interval() : chr_name(), begin(), end() {}
+Interval::Interval(uint32_t chr_id, long long begin, long long end) : chr_id(chr_id), begin(begin), end(end) {}
 
-Interval::Interval(const std::string &chr_name, const long long &begin, const long long &end)
-    : chr_name(chr_name), begin(begin), end(end) {}
+Interval::Interval(const std::string &chr_name, long long begin, long long end)
+    : chr_id(ChrDictionary::get_id(chr_name)), begin(begin), end(end) {}
 
 Interval::operator std::string() const {
-  return chr_name + ": [" + std::to_string(begin) + ", " + std::to_string(end) + ")";
+  return get_chr_name() + ": [" + std::to_string(begin) + ", " + std::to_string(end) + ")";
 }
 
 bool Interval::operator<(const Interval &other) const {
-  if (chr_name != other.chr_name)
-    return chr_name < other.chr_name;
+  if (chr_id != other.chr_id)
+    return chr_id < other.chr_id;
   if (begin != other.begin)
     return begin < other.begin;
   return end < other.end;
 }
 
 bool Interval::operator==(const Interval &other) const {
-  return chr_name == other.chr_name && begin == other.begin && end == other.end;
+  return chr_id == other.chr_id && begin == other.begin && end == other.end;
 }
 
 long long Interval::length() const { return end - begin; }
 
-std::string Interval::get_chr_name() const { return this->chr_name; }
+uint32_t Interval::get_chr_id() const { return this->chr_id; }
+
+const std::string &Interval::get_chr_name() const { return ChrDictionary::get_name(this->chr_id); }
 
 long long Interval::get_begin() const { return this->begin; }
 
 long long Interval::get_end() const { return this->end; }
 
 std::ostream &operator<<(std::ostream &os, const Interval &interval) {
-  os << interval.chr_name + ": [" + std::to_string(interval.begin) + ", " + std::to_string(interval.end) + ")";
+  os << std::string(interval);
   return os;
 }
 
@@ -1,31 +1,38 @@
 #ifndef INTERVAL_H
 #define INTERVAL_H
 
+#include <cstdint>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
-// half open intervals [b, e)
+// half open intervals [b, e), the chromosome is stored as its id in ChrDictionary
 class Interval {
 public:
-  std::string chr_name;
+  uint32_t chr_id = 0;
   long long begin = 0, end = 0;
 
-  Interval();
-  Interval(const std::string &chr_name, const long long &begin, const long long &end);
-  virtual ~Interval() = default;
+  Interval() = default;
+  Interval(uint32_t chr_id, long long begin, long long end);
+  // looks the name up in ChrDictionary, meant for reading input and for tests
+  Interval(const std::string &chr_name, long long begin, long long end);
 
   operator std::string() const;
   bool operator<(const Interval &other) const;
   bool operator==(const Interval &other) const;
 
-  virtual long long length() const final;
+  long long length() const;
 
-  virtual std::string get_chr_name() const final;
-  virtual long long get_begin() const final;
-  virtual long long get_end() const final;
+  uint32_t get_chr_id() const;
+  const std::string &get_chr_name() const;
+  long long get_begin() const;
+  long long get_end() const;
 };
 
+static_assert(sizeof(Interval) == 24);
+static_assert(std::is_trivially_copyable_v<Interval> && std::is_standard_layout_v<Interval>);
+
 std::ostream &operator<<(std::ostream &os, const Interval &interval);
 std::string interval_vector_to_string(std::vector<Interval> &intervals);
 
@@ -0,0 +1,28 @@
+#include "IntervalColumns.hpp"
+
+IntervalColumns::IntervalColumns() {}
+
+IntervalColumns::IntervalColumns(const std::vector<Interval> &intervals)
+    : IntervalColumns(intervals.begin(), intervals.end()) {}
+
+IntervalColumns::IntervalColumns(std::vector<Interval>::const_iterator first,
+                                 std::vector<Interval>::const_iterator last)
+    : chr_id(first == last ? 0 : first->chr_id), begins(last - first), ends(last - first) {
+  for (size_t idx = 0; first + idx != last; idx++) {
+    begins[idx] = first[idx].begin;
+    ends[idx] = first[idx].end;
+  }
+}
+
+size_t IntervalColumns::size() const { return begins.size(); }
+
+bool IntervalColumns::empty() const { return begins.empty(); }
+
+Interval IntervalColumns::operator[](size_t idx) const { return Interval(chr_id, begins[idx], ends[idx]); }
+
+bool IntervalColumns::is_sorted_non_overlapping() const {
+  for (size_t idx = 1; idx < size(); idx++)
+    if (begins[idx] < ends[idx - 1])
+      return false;
+  return true;
+}
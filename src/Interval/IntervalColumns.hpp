@@ -0,0 +1,25 @@
+#ifndef INTERVALCOLUMNS_H
+#define INTERVALCOLUMNS_H
+
+#include "Interval.hpp"
+#include <cstdint>
+#include <vector>
+
+// sorted non-overlapping intervals of one chromosome stored column-wise, begins and ends are kept in separate arrays
+// so scans over them touch only the column they need and compare several values at once
+class IntervalColumns {
+public:
+  uint32_t chr_id = 0;
+  std::vector<long long> begins, ends;
+
+  IntervalColumns();
+  explicit IntervalColumns(const std::vector<Interval> &intervals);
+  IntervalColumns(std::vector<Interval>::const_iterator first, std::vector<Interval>::const_iterator last);
+
+  size_t size() const;
+  bool empty() const;
+  Interval operator[](size_t idx) const;
+  bool is_sorted_non_overlapping() const;
+};
+
+#endif // INTERVALCOLUMNS_H
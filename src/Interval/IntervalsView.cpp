@@ -0,0 +1,109 @@
+#include "IntervalsView.hpp"
+#include "../Logger/Logger.hpp"
+#include <algorithm>
+#include <limits>
+
+// query intervals ending before a ref interval are skipped this many at a time, comparisons in a block are vectorized
+const size_t OVERLAP_SKIP_BLOCK = 8;
+
+IntervalsView::IntervalsView() {}
+
+IntervalsView::IntervalsView(std::shared_ptr<const IntervalColumns> source)
+    : source(source), first(0), last(source->size()), begin(std::numeric_limits<long long>::min()),
+      end(std::numeric_limits<long long>::max()) {}
+
+IntervalsView::IntervalsView(std::shared_ptr<const IntervalColumns> source, size_t first, size_t last,
+                             long long begin, long long end)
+    : source(source), first(first), last(last), begin(begin), end(end) {}
+
+size_t IntervalsView::size() const { return last - first; }
+
+bool IntervalsView::empty() const { return first == last; }
+
+Interval IntervalsView::operator[](size_t idx) const {
+  Interval interval = (*source)[first + idx];
+  interval.begin = std::max(interval.begin, begin);
+  interval.end = std::min(interval.end, end);
+  return interval;
+}
+
+Interval IntervalsView::front() const { return (*this)[0]; }
+
+Interval IntervalsView::back() const { return (*this)[size() - 1]; }
+
+std::vector<Interval> IntervalsView::to_vector() const {
+  std::vector<Interval> intervals;
+  intervals.reserve(size());
+  for (size_t idx = 0; idx < size(); idx++)
+    intervals.push_back((*this)[idx]);
+  return intervals;
+}
+
+IntervalsView IntervalsView::join(const IntervalsView &view1, const IntervalsView &view2) {
+  std::shared_ptr<const IntervalColumns> source = view1.source ? view1.source : view2.source;
+  if (view1.empty())
+    return IntervalsView(source, view2.first, view2.last, view1.begin, view2.end);
+  if (view2.empty())
+    return IntervalsView(source, view1.first, view1.last, view1.begin, view2.end);
+  return IntervalsView(source, view1.first, view2.last, view1.begin, view2.end);
+}
+
+std::vector<IntervalsView> IntervalsView::split_by_ranges(std::shared_ptr<const IntervalColumns> intervals,
+                                                          const std::vector<std::pair<long long, long long>> &ranges) {
+  if (!intervals->is_sorted_non_overlapping()) {
+    logger.error("intervals need to be non-overlapping for spliting into "
+                 "windows to happen.");
+    exit(1);
+  }
+
+  std::vector<IntervalsView> views;
+  views.reserve(ranges.size());
+
+  // both are sorted, so the first interval reaching into a range never moves back
+  size_t first = 0;
+  for (auto [range_begin, range_end] : ranges) {
+    while (first < intervals->size() && intervals->ends[first] <= range_begin)
+      first++;
+    size_t last = first;
+    while (last < intervals->size() && intervals->begins[last] < range_end)
+      last++;
+    views.push_back(IntervalsView(intervals, first, last, range_begin, range_end));
+  }
+
+  return views;
+}
+
+long long IntervalsView::count_overlaps(const IntervalsView &ref, const IntervalsView &query) {
+  if (ref.empty() || query.empty())
+    return 0;
+
+  const long long *ref_begins = ref.source->begins.data() + ref.first, *ref_ends = ref.source->ends.data() + ref.first;
+  const long long *query_begins = query.source->begins.data() + query.first,
+                  *query_ends = query.source->ends.data() + query.first;
+  size_t query_count = query.size(), query_idx = 0;
+
+  long long overlap_count = 0;
+  for (size_t ref_idx = 0; ref_idx < ref.size(); ref_idx++) {
+    // only ref intervals are clipped, a query interval in the view reaches into the range, so clipping it changes
+    // none of the comparisons below
+    long long ref_begin = std::max(ref_begins[ref_idx], ref.begin), ref_end = std::min(ref_ends[ref_idx], ref.end);
+
+    // ends of sorted non-overlapping intervals are sorted too, so the query intervals ending before ref_begin are a
+    // prefix of the rest and a block can be skipped if all of its ends are at most ref_begin
+    while (query_idx + OVERLAP_SKIP_BLOCK <= query_count) {
+      size_t ended = 0;
+#pragma omp simd reduction(+ : ended)
+      for (size_t block_idx = 0; block_idx < OVERLAP_SKIP_BLOCK; block_idx++)
+        ended += query_ends[query_idx + block_idx] <= ref_begin;
+      query_idx += ended;
+      if (ended < OVERLAP_SKIP_BLOCK)
+        break;
+    }
+    while (query_idx < query_count && query_ends[query_idx] <= ref_begin)
+      query_idx++;
+
+    overlap_count += ref_begin < ref_end && query_idx < query_count && query_begins[query_idx] < ref_end;
+  }
+
+  return overlap_count;
+}
@@ -0,0 +1,44 @@
+#ifndef INTERVALSVIEW_H
+#define INTERVALSVIEW_H
+
+#include "Interval.hpp"
+#include "IntervalColumns.hpp"
+#include <memory>
+#include <vector>
+
+// non-owning view of the intervals [first, last) of sorted non-overlapping chromosome-wide columns, clipped to
+// [begin, end). the first and the last interval are the only ones that can be clipped, so a section only keeps
+// indices and the clipped intervals are made on access
+class IntervalsView {
+public:
+  IntervalsView();
+  // view of all the intervals, nothing is clipped
+  explicit IntervalsView(std::shared_ptr<const IntervalColumns> source);
+  IntervalsView(std::shared_ptr<const IntervalColumns> source, size_t first, size_t last, long long begin,
+                long long end);
+
+  size_t size() const;
+  bool empty() const;
+  Interval operator[](size_t idx) const;
+  Interval front() const;
+  Interval back() const;
+  std::vector<Interval> to_vector() const;
+
+  // view of two adjacent views, the interval going over their common border becomes one interval again
+  static IntervalsView join(const IntervalsView &view1, const IntervalsView &view2);
+
+  // views of `intervals` clipped to every one of `ranges`, ranges have to be sorted and non-overlapping
+  static std::vector<IntervalsView> split_by_ranges(std::shared_ptr<const IntervalColumns> intervals,
+                                                    const std::vector<std::pair<long long, long long>> &ranges);
+
+  // number of ref intervals overlapping at least one query interval, both views have to be clipped to the same range.
+  // a merge over the sorted columns, query intervals that end too early are skipped a block at a time
+  static long long count_overlaps(const IntervalsView &ref, const IntervalsView &query);
+
+private:
+  std::shared_ptr<const IntervalColumns> source;
+  size_t first = 0, last = 0;
+  long long begin = 0, end = 0;
+};
+
+#endif // INTERVALSVIEW_H
@@ -5,19 +5,19 @@
 
 Section::Section() {}
 
-Section::Section(const std::string &chr_name, const long long &begin, const long long &end,
-                 bool first_ref_interval_intersected, bool last_ref_interval_intersected,
-                 bool first_query_interval_intersected, bool last_query_interval_intersected)
-    : Interval(chr_name, begin, end), first_ref_interval_intersected(first_ref_interval_intersected),
+Section::Section(uint32_t chr_id, const long long &begin, const long long &end, bool first_ref_interval_intersected,
+                 bool last_ref_interval_intersected, bool first_query_interval_intersected,
+                 bool last_query_interval_intersected)
+    : Interval(chr_id, begin, end), first_ref_interval_intersected(first_ref_interval_intersected),
       last_ref_interval_intersected(last_ref_interval_intersected),
       first_query_interval_intersected(first_query_interval_intersected),
       last_query_interval_intersected(last_query_interval_intersected) {}
 
-Section::Section(const std::string &chr_name, const long long &begin, const long long &end,
-                 bool first_ref_interval_intersected, bool last_ref_interval_intersected,
-                 bool first_query_interval_intersected, bool last_query_interval_intersected,
-                 const std::vector<Interval> &ref_intervals, const std::vector<Interval> &query_intervals)
-    : Interval(chr_name, begin, end), first_ref_interval_intersected(first_ref_interval_intersected),
+Section::Section(uint32_t chr_id, const long long &begin, const long long &end, bool first_ref_interval_intersected,
+                 bool last_ref_interval_intersected, bool first_query_interval_intersected,
+                 bool last_query_interval_intersected, const IntervalsView &ref_intervals,
+                 const IntervalsView &query_intervals)
+    : Interval(chr_id, begin, end), first_ref_interval_intersected(first_ref_interval_intersected),
       last_ref_interval_intersected(last_ref_interval_intersected),
       first_query_interval_intersected(first_query_interval_intersected),
       last_query_interval_intersected(last_query_interval_intersected), ref_intervals(ref_intervals),
@@ -31,19 +31,17 @@ bool Section::get_first_query_interval_intersected() const { return this->first_
 
 bool Section::get_last_query_interval_intersected() const { return this->last_query_interval_intersected; }
 
-std::vector<Interval> Section::get_ref_intervals() const { return this->ref_intervals; }
+const IntervalsView &Section::get_ref_intervals() const { return this->ref_intervals; }
 
-void Section::set_ref_intervals(const std::vector<Interval> &new_ref_intervals) {
-  this->ref_intervals = new_ref_intervals;
-}
+void Section::set_ref_intervals(const IntervalsView &new_ref_intervals) { this->ref_intervals = new_ref_intervals; }
 
-std::vector<Interval> Section::get_query_intervals() const { return this->query_intervals; }
+const IntervalsView &Section::get_query_intervals() const { return this->query_intervals; }
 
-void Section::set_query_intervals(const std::vector<Interval> &new_query_intervals) {
+void Section::set_query_intervals(const IntervalsView &new_query_intervals) {
   this->query_intervals = new_query_intervals;
 }
 
-SectionProbs Section::get_probs() const { return this->probs; }
+const SectionProbs &Section::get_probs() const { return this->probs; }
 
 void Section::set_probs(const SectionProbs &new_probs) { this->probs = new_probs; }
 
@@ -58,7 +56,7 @@ std::ostream &operator<<(std::ostream &os, const Section &section) {
   os << "overlap_count: " << section.get_overlap_count() << "\n";
   os << "first/last_ref_overflow: " << section.get_first_ref_interval_intersected() << " "
      << section.get_last_ref_interval_intersected() << "\n";
-  os << to_string(section.get_ref_intervals()) << "\n";
+  os << to_string(section.get_ref_intervals().to_vector()) << "\n";
   os << "first/last_query_overflow: " << section.get_first_query_interval_intersected() << " "
      << section.get_last_query_interval_intersected() << "\n";
   os << "section_probs: " << to_string(section.get_probs().get_normal()) << " "
@@ -69,7 +67,7 @@ std::ostream &operator<<(std::ostream &os, const Section &section) {
 }
 
 bool Section::operator==(const Section &other) const {
-  return this->chr_name == other.chr_name && this->begin == other.begin && this->end == other.end &&
+  return this->chr_id == other.chr_id && this->begin == other.begin && this->end == other.end &&
          this->first_ref_interval_intersected == other.first_ref_interval_intersected &&
          this->last_ref_interval_intersected == other.last_ref_interval_intersected &&
          this->first_query_interval_intersected == other.first_query_interval_intersected &&
@@ -3,6 +3,7 @@
 
 #include "../Results/SectionProbs.hpp"
 #include "Interval.hpp"
+#include "IntervalsView.hpp"
 #include <string>
 
 // half open intervals [b, e), but with extra info (whether first interval is from the previous section and wheter last
@@ -10,23 +11,23 @@
 class Section : public Interval {
 public:
   Section();
-  Section(const std::string &chr_name, const long long &begin, const long long &end,
-          bool first_ref_interval_intersected, bool last_ref_interval_intersected,
-          bool first_query_interval_intersected, bool last_query_interval_intersected);
-  Section(const std::string &chr_name, const long long &begin, const long long &end, bool first_interval_intersected,
+  Section(uint32_t chr_id, const long long &begin, const long long &end, bool first_ref_interval_intersected,
           bool last_ref_interval_intersected, bool first_query_interval_intersected,
-          bool last_query_interval_intersected, const std::vector<Interval> &ref_intervals,
-          const std::vector<Interval> &query_intervals);
+          bool last_query_interval_intersected);
+  Section(uint32_t chr_id, const long long &begin, const long long &end, bool first_interval_intersected,
+          bool last_ref_interval_intersected, bool first_query_interval_intersected,
+          bool last_query_interval_intersected, const IntervalsView &ref_intervals,
+          const IntervalsView &query_intervals);
 
   bool get_first_ref_interval_intersected() const;
   bool get_last_ref_interval_intersected() const;
   bool get_first_query_interval_intersected() const;
   bool get_last_query_interval_intersected() const;
-  std::vector<Interval> get_ref_intervals() const;
-  void set_ref_intervals(const std::vector<Interval> &new_ref_intervals);
-  std::vector<Interval> get_query_intervals() const;
-  void set_query_intervals(const std::vector<Interval> &new_query_intervals);
-  SectionProbs get_probs() const;
+  const IntervalsView &get_ref_intervals() const;
+  void set_ref_intervals(const IntervalsView &new_ref_intervals);
+  const IntervalsView &get_query_intervals() const;
+  void set_query_intervals(const IntervalsView &new_query_intervals);
+  const SectionProbs &get_probs() const;
   void set_probs(const SectionProbs &new_probs);
   long long get_overlap_count() const;
   void set_overlap_count(long long new_overlap_count);
@@ -35,7 +36,7 @@ public:
 private:
   bool first_ref_interval_intersected, last_ref_interval_intersected, first_query_interval_intersected,
       last_query_interval_intersected;
-  std::vector<Interval> ref_intervals, query_intervals;
+  IntervalsView ref_intervals, query_intervals;
   SectionProbs probs;
   long long overlap_count;
 };
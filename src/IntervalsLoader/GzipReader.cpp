@@ -0,0 +1,208 @@
+#include "GzipReader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <omp.h>
+
+// uncompressed bytes handed to the parser at once
+const size_t GZIP_BATCH_SIZE = 64 << 20;
+
+// output buffer growth step for sequential inflating
+const size_t GZIP_OUTPUT_STEP = 1 << 20;
+
+// zlib takes input sizes as 32-bit numbers, larger files are fed in pieces
+const size_t GZIP_INPUT_PIECE = 1 << 30;
+
+bool is_gzip(const char *data, size_t size) {
+  return size >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+}
+
+static uint32_t read_uint32_le(const char *data) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+// size of the gzip member header at `data` or 0 if it is invalid. if the header has the BGZF subfield, `block_size`
+// is set to the size of the whole member, otherwise to 0
+static size_t parse_gzip_header(const char *data, size_t size, size_t &block_size) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  const unsigned char FHCRC = 2, FEXTRA = 4, FNAME = 8, FCOMMENT = 16;
+
+  block_size = 0;
+  if (size < 10 || !is_gzip(data, size) || bytes[2] != Z_DEFLATED)
+    return 0;
+
+  size_t pos = 10;
+  if (bytes[3] & FEXTRA) {
+    if (pos + 2 > size)
+      return 0;
+    size_t extra_size = bytes[pos] | bytes[pos + 1] << 8, extra_end = pos + 2 + extra_size;
+    if (extra_end > size)
+      return 0;
+    for (size_t field = pos + 2; field + 4 <= extra_end;) {
+      size_t field_size = bytes[field + 2] | bytes[field + 3] << 8;
+      if (bytes[field] == 'B' && bytes[field + 1] == 'C' && field_size == 2 && field + 6 <= extra_end)
+        block_size = (bytes[field + 4] | bytes[field + 5] << 8) + 1;
+      field += 4 + field_size;
+    }
+    pos = extra_end;
+  }
+  for (unsigned char flag : {FNAME, FCOMMENT}) {
+    if (bytes[3] & flag) {
+      while (pos < size && bytes[pos])
+        pos++;
+      pos++;
+    }
+  }
+  if (bytes[3] & FHCRC)
+    pos += 2;
+
+  return pos <= size ? pos : 0;
+}
+
+// inflates one raw deflate stream of a BGZF block and checks it against the block's size and CRC
+static bool inflate_block(const char *in, size_t in_size, char *out, size_t out_size, uint32_t crc) {
+  z_stream block_stream;
+  std::memset(&block_stream, 0, sizeof(block_stream));
+  if (inflateInit2(&block_stream, -MAX_WBITS) != Z_OK)
+    return false;
+
+  block_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+  block_stream.avail_in = in_size;
+  block_stream.next_out = reinterpret_cast<Bytef *>(out);
+  block_stream.avail_out = out_size;
+  int status = inflate(&block_stream, Z_FINISH);
+  bool inflated = status == Z_STREAM_END && block_stream.total_out == out_size;
+  inflateEnd(&block_stream);
+
+  return inflated && crc32(0, reinterpret_cast<const Bytef *>(out), out_size) == crc;
+}
+
+GzipReader::GzipReader(const char *data, size_t size, const std::string &file_path)
+    : data(data), size(size), file_path(file_path) {
+  size_t block_size;
+  if (!parse_gzip_header(data, size, block_size))
+    fail("invalid gzip header");
+  bgzf = block_size > 0;
+  std::memset(&stream, 0, sizeof(stream));
+}
+
+GzipReader::~GzipReader() {
+  if (stream_open)
+    inflateEnd(&stream);
+}
+
+bool GzipReader::read_batch(std::string &out) {
+  if (failed())
+    return false;
+  return bgzf ? read_bgzf_batch(out) : read_gzip_batch(out);
+}
+
+bool GzipReader::is_bgzf() const { return bgzf; }
+
+bool GzipReader::failed() const { return !error_message.empty(); }
+
+const std::string &GzipReader::error() const { return error_message; }
+
+bool GzipReader::read_bgzf_batch(std::string &out) {
+  if (offset >= size)
+    return false;
+
+  struct Block {
+    size_t in_begin, in_size, out_begin, out_size;
+    uint32_t crc;
+  };
+
+  // block headers and trailers are read sequentially, which is cheap, the blocks themselves are inflated in parallel
+  std::vector<Block> blocks;
+  size_t batch_size = 0;
+  while (offset < size && batch_size < GZIP_BATCH_SIZE) {
+    size_t block_size, header_size = parse_gzip_header(data + offset, size - offset, block_size);
+    if (!header_size || block_size < header_size + 8 || offset + block_size > size) {
+      fail("invalid BGZF block at byte " + std::to_string(offset));
+      return false;
+    }
+
+    const char *trailer = data + offset + block_size - 8;
+    blocks.push_back({offset + header_size, block_size - header_size - 8, batch_size, read_uint32_le(trailer + 4),
+                      read_uint32_le(trailer)});
+    batch_size += blocks.back().out_size;
+    offset += block_size;
+  }
+
+  size_t out_begin = out.size();
+  out.resize(out_begin + batch_size);
+  std::vector<char> corrupted(blocks.size());
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t block_idx = 0; block_idx < blocks.size(); block_idx++) {
+    const Block &block = blocks[block_idx];
+    corrupted[block_idx] = !inflate_block(data + block.in_begin, block.in_size,
+                                          out.data() + out_begin + block.out_begin, block.out_size, block.crc);
+  }
+
+  for (size_t block_idx = 0; block_idx < blocks.size(); block_idx++) {
+    if (corrupted[block_idx]) {
+      fail("corrupted BGZF block at byte " + std::to_string(blocks[block_idx].in_begin));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool GzipReader::read_gzip_batch(std::string &out) {
+  if (!stream_open) {
+    if (offset >= size)
+      return false;
+    // 16 tells zlib to expect a gzip header
+    if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK) {
+      fail("zlib initialization failed");
+      return false;
+    }
+    stream_open = true;
+  }
+
+  size_t produced = 0;
+  while (produced < GZIP_BATCH_SIZE) {
+    if (stream.avail_in == 0 && offset < size) {
+      size_t piece = std::min(size - offset, GZIP_INPUT_PIECE);
+      stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + offset));
+      stream.avail_in = piece;
+      offset += piece;
+    }
+
+    size_t out_begin = out.size();
+    out.resize(out_begin + GZIP_OUTPUT_STEP);
+    stream.next_out = reinterpret_cast<Bytef *>(out.data() + out_begin);
+    stream.avail_out = GZIP_OUTPUT_STEP;
+    int status = inflate(&stream, Z_NO_FLUSH);
+    out.resize(out.size() - stream.avail_out);
+    produced += GZIP_OUTPUT_STEP - stream.avail_out;
+
+    if (status == Z_STREAM_END) {
+      // more members can follow, as in files made with `cat a.gz b.gz`
+      if (stream.avail_in == 0 && offset >= size) {
+        inflateEnd(&stream);
+        stream_open = false;
+        return true;
+      }
+      inflateReset(&stream);
+    } else if (status == Z_BUF_ERROR && stream.avail_in == 0 && offset >= size) {
+      fail("the file is truncated");
+      return false;
+    } else if (status != Z_OK && status != Z_BUF_ERROR) {
+      fail(stream.msg ? stream.msg : "corrupted data");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// only the first error is kept, the reader returns no more batches after it
+void GzipReader::fail(const std::string &reason) {
+  if (error_message.empty())
+    error_message = "Failed to decompress " + file_path + ": " + reason + ".";
+}
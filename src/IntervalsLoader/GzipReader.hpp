@@ -0,0 +1,44 @@
+#ifndef GZIPREADER_H
+#define GZIPREADER_H
+
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+bool is_gzip(const char *data, size_t size);
+
+// decompresses a gzip file held in memory batch by batch, so the parser can work on one batch while the rest of the
+// file stays compressed. BGZF files (a series of small independent gzip blocks, as written by bgzip) are split into
+// their blocks, which are inflated in parallel straight into their place in the batch, other gzip files are inflated
+// sequentially
+class GzipReader {
+public:
+  GzipReader(const char *data, size_t size, const std::string &file_path);
+  ~GzipReader();
+  GzipReader(const GzipReader &) = delete;
+  GzipReader &operator=(const GzipReader &) = delete;
+
+  // appends the next batch of decompressed bytes to `out`, returns false once the whole file has been read or the
+  // data turned out to be invalid, in which case failed() is set
+  bool read_batch(std::string &out);
+
+  bool is_bgzf() const;
+  bool failed() const;
+  // message to log when failed() is set
+  const std::string &error() const;
+
+private:
+  const char *data;
+  size_t size, offset = 0;
+  std::string file_path;
+  bool bgzf;
+  z_stream stream;
+  bool stream_open = false;
+  std::string error_message;
+
+  bool read_bgzf_batch(std::string &out);
+  bool read_gzip_batch(std::string &out);
+  void fail(const std::string &reason);
+};
+
+#endif // GZIPREADER_H
@@ -0,0 +1,163 @@
+#include "IntervalsCache.hpp"
+#include "../Interval/ChrDictionary.hpp"
+#include "../Logger/Logger.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+static uint64_t align_to_words(uint64_t size) { return (size + 7) / 8 * 8; }
+
+// FNV-1a over 8 byte words, sizes are always multiples of 8
+static uint64_t checksum(const char *data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t offset = 0; offset < size; offset += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + offset, 8);
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static uint64_t header_checksum(const IntervalsCacheHeader &header) {
+  return checksum(reinterpret_cast<const char *>(&header), offsetof(IntervalsCacheHeader, header_checksum));
+}
+
+bool is_intervals_cache(const char *data, size_t size) {
+  return size >= sizeof(INTERVALS_CACHE_MAGIC) && std::memcmp(data, INTERVALS_CACHE_MAGIC, 8) == 0;
+}
+
+bool is_intervals_cache_file(const std::string &file_path) {
+  std::ifstream input_file(file_path, std::ios::binary);
+  char magic[sizeof(INTERVALS_CACHE_MAGIC)];
+  return input_file.read(magic, sizeof(magic)) && is_intervals_cache(magic, sizeof(magic));
+}
+
+std::vector<Interval> read_intervals_cache(const char *data, size_t size, const std::string &file_path) {
+  IntervalsCacheHeader header;
+  if (size < sizeof(header)) {
+    logger.error("Intervals cache " + file_path + " is truncated.");
+    exit(1);
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if (header.header_checksum != header_checksum(header)) {
+    logger.error("Intervals cache " + file_path + " has a corrupted header.");
+    exit(1);
+  }
+
+  if (header.version != INTERVALS_CACHE_VERSION) {
+    logger.error("Intervals cache " + file_path + " has version " + std::to_string(header.version) +
+                 ", but only version " + std::to_string(INTERVALS_CACHE_VERSION) +
+                 " is supported. Please convert the intervals again.");
+    exit(1);
+  }
+
+  const char *payload = data + sizeof(header);
+  // the columns take 16 bytes per interval, compared by division so that a forged count can't overflow
+  if (size - sizeof(header) != header.payload_size || header.interval_count > header.payload_size / 16 ||
+      header.payload_size - 16 * header.interval_count < sizeof(IntervalsCacheChr) * header.chr_count) {
+    logger.error("Intervals cache " + file_path + " is truncated.");
+    exit(1);
+  }
+
+  if (header.payload_checksum != checksum(payload, header.payload_size)) {
+    logger.error("Intervals cache " + file_path + " is corrupted, its checksum doesn't match.");
+    exit(1);
+  }
+
+  std::vector<std::pair<uint32_t, IntervalsCacheChr>> chrs(header.chr_count);
+  for (uint32_t chr_idx = 0; chr_idx < header.chr_count; chr_idx++) {
+    IntervalsCacheChr chr;
+    std::memcpy(&chr, payload + chr_idx * sizeof(IntervalsCacheChr), sizeof(chr));
+    if (chr.name_length > header.payload_size || chr.name_offset > header.payload_size - chr.name_length ||
+        chr.interval_count > header.interval_count ||
+        chr.first_interval > header.interval_count - chr.interval_count) {
+      logger.error("Intervals cache " + file_path + " has an invalid chromosome table.");
+      exit(1);
+    }
+    chrs[chr_idx] = {ChrDictionary::get_id(std::string(payload + chr.name_offset, chr.name_length)), chr};
+  }
+
+  // the ranges of the chromosomes have to cover all intervals exactly once, and every chromosome has to appear once
+  std::sort(chrs.begin(), chrs.end(),
+            [](const auto &a, const auto &b) { return a.second.first_interval < b.second.first_interval; });
+  uint64_t covered = 0;
+  bool valid_ranges = true;
+  for (const auto &[chr_id, chr] : chrs) {
+    valid_ranges = valid_ranges && chr.first_interval == covered;
+    covered += chr.interval_count;
+  }
+  std::sort(chrs.begin(), chrs.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  auto same_chr = [](const auto &a, const auto &b) { return a.first == b.first; };
+  if (!valid_ranges || covered != header.interval_count ||
+      std::adjacent_find(chrs.begin(), chrs.end(), same_chr) != chrs.end()) {
+    logger.error("Intervals cache " + file_path + " has an invalid chromosome table.");
+    exit(1);
+  }
+
+  const char *begins = payload + header.payload_size - 16 * header.interval_count;
+  const char *ends = begins + 8 * header.interval_count;
+
+  std::vector<Interval> intervals(header.interval_count);
+  size_t interval_idx = 0;
+  for (const auto &[chr_id, chr] : chrs) {
+    for (uint64_t idx = chr.first_interval; idx < chr.first_interval + chr.interval_count; idx++) {
+      Interval &interval = intervals[interval_idx++];
+      interval.chr_id = chr_id;
+      std::memcpy(&interval.begin, begins + 8 * idx, 8);
+      std::memcpy(&interval.end, ends + 8 * idx, 8);
+    }
+  }
+
+  return intervals;
+}
+
+void write_intervals_cache(const std::string &file_path, const std::vector<Interval> &intervals) {
+  std::vector<IntervalsCacheChr> chrs;
+  std::string names;
+  for (size_t idx = 0; idx < intervals.size(); idx++) {
+    if (idx == 0 || intervals[idx].chr_id != intervals[idx - 1].chr_id) {
+      const std::string &chr_name = intervals[idx].get_chr_name();
+      chrs.push_back({names.size(), chr_name.size(), idx, 0});
+      names += chr_name;
+    }
+    chrs.back().interval_count++;
+  }
+
+  uint64_t table_size = chrs.size() * sizeof(IntervalsCacheChr), names_size = align_to_words(names.size());
+  for (IntervalsCacheChr &chr : chrs)
+    chr.name_offset += table_size;
+
+  std::string payload(table_size + names_size + 16 * intervals.size(), '\0');
+  std::memcpy(payload.data(), chrs.data(), table_size);
+  std::memcpy(payload.data() + table_size, names.data(), names.size());
+  char *begins = payload.data() + table_size + names_size, *ends = begins + 8 * intervals.size();
+  for (size_t idx = 0; idx < intervals.size(); idx++) {
+    std::memcpy(begins + 8 * idx, &intervals[idx].begin, 8);
+    std::memcpy(ends + 8 * idx, &intervals[idx].end, 8);
+  }
+
+  IntervalsCacheHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, INTERVALS_CACHE_MAGIC, sizeof(header.magic));
+  header.version = INTERVALS_CACHE_VERSION;
+  header.chr_count = chrs.size();
+  header.interval_count = intervals.size();
+  header.payload_size = payload.size();
+  header.payload_checksum = checksum(payload.data(), payload.size());
+  header.header_checksum = header_checksum(header);
+
+  std::ofstream output_file(file_path, std::ios::binary);
+  if (!output_file.is_open()) {
+    logger.error("Failed to open intervals cache file for writing: " + file_path);
+    exit(1);
+  }
+  output_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output_file.write(payload.data(), payload.size());
+  if (!output_file) {
+    logger.error("Failed to write intervals cache file: " + file_path);
+    exit(1);
+  }
+}
@@ -0,0 +1,47 @@
+#ifndef INTERVALSCACHE_H
+#define INTERVALSCACHE_H
+
+#include "../Interval/Interval.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// binary interval files written by `emcdp convert`. the file is a header followed by a payload of
+//  - a table of chromosomes, each with the offset and length of its name and the range of its intervals,
+//  - the names,
+//  - the begin column and the end column of all intervals, grouped by chromosome, sorted and merged.
+// all numbers are little-endian and every part starts at a multiple of 8 bytes
+const char INTERVALS_CACHE_MAGIC[8] = {'E', 'M', 'C', 'D', 'P', 'I', 'V', '\n'};
+const uint32_t INTERVALS_CACHE_VERSION = 1;
+
+struct IntervalsCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t chr_count;
+  uint64_t interval_count;
+  uint64_t payload_size;
+  uint64_t payload_checksum;
+  // checksum of all the fields above
+  uint64_t header_checksum;
+};
+
+struct IntervalsCacheChr {
+  uint64_t name_offset;
+  uint64_t name_length;
+  uint64_t first_interval;
+  uint64_t interval_count;
+};
+
+bool is_intervals_cache(const char *data, size_t size);
+
+bool is_intervals_cache_file(const std::string &file_path);
+
+// checks the header and both checksums and reads the columns straight from `data`, chromosomes come out ordered by
+// their ids, so the result is sorted
+std::vector<Interval> read_intervals_cache(const char *data, size_t size, const std::string &file_path);
+
+// `intervals` have to be sorted and merged
+void write_intervals_cache(const std::string &file_path, const std::vector<Interval> &intervals);
+
+#endif // INTERVALSCACHE_H
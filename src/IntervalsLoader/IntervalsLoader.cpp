@@ -0,0 +1,246 @@
+#include "IntervalsLoader.hpp"
+#include "../Interval/ChrDictionary.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// chunks smaller than this are not worth a separate task
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+// more chunks than threads, so that a thread with short lines doesn't wait for the others
+const size_t CHUNKS_PER_THREAD = 4;
+
+MappedFile::MappedFile(const std::string &file_path) {
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0) {
+    close(fd);
+    return;
+  }
+
+  mapped_size = file_stat.st_size;
+  if (mapped_size > 0) {
+    void *address = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+      close(fd);
+      return;
+    }
+    madvise(address, mapped_size, MADV_SEQUENTIAL);
+    mapped = static_cast<const char *>(address);
+  }
+
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+  opened = true;
+  profiler.count(Counter::BYTES_READ, mapped_size);
+}
+
+MappedFile::~MappedFile() {
+  if (mapped)
+    munmap(const_cast<char *>(mapped), mapped_size);
+}
+
+bool MappedFile::is_open() const { return opened; }
+
+const char *MappedFile::data() const { return mapped; }
+
+size_t MappedFile::size() const { return mapped_size; }
+
+// accepts what std::stoll accepted in the old parser, that is leading whitespace and a sign, but only whitespace
+// after the number
+static bool parse_number(std::string_view field, long long &value) {
+  const char *pos = field.data(), *field_end = field.data() + field.size();
+  while (pos < field_end && std::isspace((unsigned char)*pos))
+    pos++;
+  if (pos + 1 < field_end && *pos == '+' && std::isdigit((unsigned char)pos[1]))
+    pos++;
+
+  auto [number_end, ec] = std::from_chars(pos, field_end, value);
+  if (ec != std::errc())
+    return false;
+
+  return std::all_of(number_end, field_end, [](char c) { return std::isspace((unsigned char)c); });
+}
+
+bool parse_interval_fields(std::string_view line, std::string_view &chr_name, long long &begin, long long &end,
+                           std::string &error) {
+  // a single trailing tab used to be dropped by getline, so it is still allowed
+  std::string_view fields = line;
+  if (!fields.empty() && fields.back() == '\t')
+    fields.remove_suffix(1);
+
+  size_t first_tab = fields.find('\t');
+  size_t second_tab = first_tab == std::string_view::npos ? first_tab : fields.find('\t', first_tab + 1);
+  if (fields.empty() || second_tab == std::string_view::npos ||
+      fields.find('\t', second_tab + 1) != std::string_view::npos) {
+    error = "Expected 3 values in " + std::string(line) + " split by \t.";
+    return false;
+  }
+
+  chr_name = fields.substr(0, first_tab);
+  if (!parse_number(fields.substr(first_tab + 1, second_tab - first_tab - 1), begin) ||
+      !parse_number(fields.substr(second_tab + 1), end)) {
+    error = "Invalid line format on line: " + std::string(line) + ". Should be {chr_name} {begin} {end}.";
+    return false;
+  }
+
+  return true;
+}
+
+static size_t count_lines(const char *chunk_begin, const char *chunk_end) {
+  if (chunk_begin == chunk_end)
+    return 0;
+  return std::count(chunk_begin, chunk_end, '\n') + (chunk_end[-1] != '\n');
+}
+
+// parses the lines of one chunk into `intervals`, returns false and fills `error` at the first invalid line
+static bool parse_chunk(const char *chunk_begin, const char *chunk_end, bool is_closed, Interval *intervals,
+                        std::string &error) {
+  // consecutive lines are almost always on the same chromosome, so the dictionary is asked only on a change
+  std::string_view last_chr_name;
+  uint32_t last_chr_id = 0;
+  bool has_last_chr = false;
+
+  for (const char *pos = chunk_begin; pos < chunk_end;) {
+    const char *line_end = static_cast<const char *>(memchr(pos, '\n', chunk_end - pos));
+    if (!line_end)
+      line_end = chunk_end;
+    std::string_view line(pos, line_end - pos);
+    pos = line_end + 1;
+
+    std::string_view chr_name;
+    long long begin, end;
+    if (!parse_interval_fields(line, chr_name, begin, end, error))
+      return false;
+
+    if (is_closed)
+      end--;
+
+    if (begin >= end) {
+      error = "Begin should be strictly smaller than end in stated intervals.";
+      return false;
+    }
+
+    if (begin < 0 || end < 0) {
+      error = "Interval bounds should be non-negative.";
+      return false;
+    }
+
+    if (!has_last_chr || chr_name != last_chr_name) {
+      last_chr_name = chr_name;
+      last_chr_id = ChrDictionary::get_id(std::string(chr_name));
+      has_last_chr = true;
+    }
+
+    *intervals++ = Interval(last_chr_id, begin, end);
+  }
+
+  return true;
+}
+
+bool parse_intervals_buffer(const char *data, size_t size, bool is_closed, std::vector<Interval> &intervals,
+                            std::string &error) {
+  intervals.clear();
+  if (size == 0)
+    return true;
+
+  size_t chunk_count = std::clamp(size / MIN_CHUNK_SIZE, (size_t)1, omp_get_max_threads() * CHUNKS_PER_THREAD);
+
+  // every chunk but the last one ends right after a newline
+  std::vector<const char *> chunk_bounds(chunk_count + 1);
+  chunk_bounds[0] = data;
+  chunk_bounds[chunk_count] = data + size;
+  for (size_t chunk_idx = 1; chunk_idx < chunk_count; chunk_idx++) {
+    const char *pos = std::max(chunk_bounds[chunk_idx - 1], data + size * chunk_idx / chunk_count);
+    const char *newline = static_cast<const char *>(memchr(pos, '\n', data + size - pos));
+    chunk_bounds[chunk_idx] = newline ? newline + 1 : data + size;
+  }
+
+  std::vector<size_t> first_line_of_chunk(chunk_count + 1);
+#pragma omp parallel for schedule(dynamic)
+  for (size_t chunk_idx = 0; chunk_idx < chunk_count; chunk_idx++)
+    first_line_of_chunk[chunk_idx + 1] = count_lines(chunk_bounds[chunk_idx], chunk_bounds[chunk_idx + 1]);
+  for (size_t chunk_idx = 0; chunk_idx < chunk_count; chunk_idx++)
+    first_line_of_chunk[chunk_idx + 1] += first_line_of_chunk[chunk_idx];
+
+  intervals.resize(first_line_of_chunk[chunk_count]);
+  std::vector<std::string> errors(chunk_count);
+  std::vector<char> failed(chunk_count);
+
+#pragma omp parallel for schedule(dynamic)
+  for (size_t chunk_idx = 0; chunk_idx < chunk_count; chunk_idx++)
+    failed[chunk_idx] = !parse_chunk(chunk_bounds[chunk_idx], chunk_bounds[chunk_idx + 1], is_closed,
+                                     intervals.data() + first_line_of_chunk[chunk_idx], errors[chunk_idx]);
+
+  for (size_t chunk_idx = 0; chunk_idx < chunk_count; chunk_idx++) {
+    if (failed[chunk_idx]) {
+      error = errors[chunk_idx];
+      intervals.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::vector<Interval> parse_intervals_buffer(const char *data, size_t size, bool is_closed) {
+  std::vector<Interval> intervals;
+  std::string error;
+  if (!parse_intervals_buffer(data, size, is_closed, intervals, error)) {
+    logger.error(error);
+    exit(1);
+  }
+  return intervals;
+}
+
+std::vector<Interval> parse_intervals_stream(GzipReader &reader, bool is_closed) {
+  std::vector<Interval> intervals;
+  std::string text;
+  while (reader.read_batch(text)) {
+    size_t parsed_size = text.rfind('\n') + 1;
+    std::vector<Interval> batch_intervals = parse_intervals_buffer(text.data(), parsed_size, is_closed);
+    intervals.insert(intervals.end(), batch_intervals.begin(), batch_intervals.end());
+    text.erase(0, parsed_size);
+  }
+
+  if (reader.failed()) {
+    logger.error(reader.error());
+    exit(1);
+  }
+
+  std::vector<Interval> last_intervals = parse_intervals_buffer(text.data(), text.size(), is_closed);
+  intervals.insert(intervals.end(), last_intervals.begin(), last_intervals.end());
+  return intervals;
+}
+
+bool read_whole_file(const std::string &file_path, std::string &content) {
+  MappedFile input_file(file_path);
+  if (!input_file.is_open())
+    return false;
+
+  content.clear();
+  if (is_gzip(input_file.data(), input_file.size())) {
+    GzipReader reader(input_file.data(), input_file.size(), file_path);
+    while (reader.read_batch(content))
+      ;
+    if (reader.failed()) {
+      logger.error(reader.error());
+      exit(1);
+    }
+  } else {
+    content.assign(input_file.data(), input_file.size());
+  }
+  return true;
+}
@@ -0,0 +1,49 @@
+#ifndef INTERVALSLOADER_H
+#define INTERVALSLOADER_H
+
+#include "../Interval/Interval.hpp"
+#include "GzipReader.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// read-only memory mapping of a whole file, released in the destructor
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &file_path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool is_open() const;
+  const char *data() const;
+  size_t size() const;
+
+private:
+  bool opened = false;
+  const char *mapped = nullptr;
+  size_t mapped_size = 0;
+};
+
+// splits {chr_name}\t{begin}\t{end} into its fields, on failure returns false and fills `error` with the message
+// parse_intervals_line has always logged
+bool parse_interval_fields(std::string_view line, std::string_view &chr_name, long long &begin, long long &end,
+                           std::string &error);
+
+// parses all lines of the buffer, the buffer is split into chunks at newlines which are parsed in parallel straight
+// into their place in the result. checks and messages are the same as in parse_intervals_line and load_intervals, if
+// more lines are invalid the first one is reported. on failure returns false and fills `error`
+bool parse_intervals_buffer(const char *data, size_t size, bool is_closed, std::vector<Interval> &intervals,
+                            std::string &error);
+
+// same as above, but logs the error and exits
+std::vector<Interval> parse_intervals_buffer(const char *data, size_t size, bool is_closed = false);
+
+// parses a compressed file batch by batch, every batch is parsed up to its last newline and the rest is carried over
+std::vector<Interval> parse_intervals_stream(GzipReader &reader, bool is_closed = false);
+
+// whole content of a plain or gzip-compressed file, returns false if the file can't be opened
+bool read_whole_file(const std::string &file_path, std::string &content);
+
+#endif // INTERVALSLOADER_H
@@ -2,8 +2,12 @@
 #include <ctime>
 #include <format>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 
+// models log from inside OpenMP regions, entries are written one at a time
+static std::mutex log_mutex;
+
 Logger::Logger(const std::string &output_path) {
   if (!output_path.empty()) {
     file_output.open(output_path, std::ios::trunc);
@@ -22,6 +26,8 @@ Logger::~Logger() {
 }
 
 void Logger::log(Level level, const std::string &message) {
+  // get_timestamp uses std::localtime, which is not thread safe either
+  std::lock_guard<std::mutex> lock(log_mutex);
   std::string log_entry = "[" + get_timestamp() + "] - [" + level_to_string(level) + "]\t- " + message;
 
   if (log_to_file) {
@@ -1,20 +1,27 @@
 #include "MarkovChain.hpp"
+#include "../Helpers/Helpers.hpp"
 #include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
 
+#include <cmath>
 #include <iostream>
 
 MarkovChain::MarkovChain() {}
 
 MarkovChain::MarkovChain(TransitionMatrix T, TransitionMatrix T_MOD) : T(T), T_MOD(T_MOD) {
   this->calculate_stationary_distribution();
+  this->check_closed_forms();
 }
 
 MarkovChain::MarkovChain(TransitionMatrix T, TransitionMatrix T_MOD, std::array<long double, 2> stationary_distribution)
-    : T(T), T_MOD(T_MOD) {}
+    : T(T), T_MOD(T_MOD) {
+  this->check_closed_forms();
+}
 
-MarkovChain::MarkovChain(long long chr_len, const std::vector<Interval> &query_intervals) {
-  this->calculate_transition_matrices(chr_len, query_intervals);
+MarkovChain::MarkovChain(long long chr_len, const std::vector<Interval> &query_intervals, bool query_as_bases) {
+  this->calculate_transition_matrices(chr_len, query_intervals, query_as_bases);
   this->calculate_stationary_distribution();
+  this->check_closed_forms();
 }
 
 TransitionMatrix MarkovChain::get_T() const { return this->T; }
@@ -23,6 +30,39 @@ TransitionMatrix MarkovChain::get_T_MOD() const { return this->T_MOD; }
 
 StationaryDistribution MarkovChain::get_stationary_distribution() const { return this->stationary_distribution; };
 
+// with b = T[0][1], c = T[1][0] the eigenvalues of T are 1 and 1 - b - c, which gives
+// T^n = I - (1 - (1 - b - c)^n) / (b + c) * [[b, -b], [-c, c]]
+// 1 - (1 - b - c)^n is evaluated with expm1/log1p, so it stays accurate even when n * (b + c) is tiny
+TransitionMatrix MarkovChain::power_T(long long n) const {
+  profiler.count(Counter::MATRIX_POWERS, 1);
+  if (!this->has_closed_form_T)
+    return binary_exponentiation(this->T, n);
+  if (n <= 0)
+    return {{{{1, 0}}, {{0, 1}}}};
+
+  long double b = this->T[0][1], c = this->T[1][0];
+  long double denom = b + c;
+  long double one_minus_lambda_pow =
+      denom < 1 ? -std::expm1(n * std::log1p(-denom)) : 1 - std::pow(1 - denom, (long double)n);
+  long double scale = one_minus_lambda_pow / denom;
+
+  return {{{{1 - b * scale, b * scale}}, {{c * scale, 1 - c * scale}}}};
+}
+
+// T_MOD = [[a, 0], [c, 0]], so for n >= 1 we get T_MOD^n = [[a^n, 0], [c * a^(n-1), 0]]
+TransitionMatrix MarkovChain::power_T_MOD(long long n) const {
+  profiler.count(Counter::MATRIX_POWERS, 1);
+  if (!this->has_closed_form_T_MOD)
+    return binary_exponentiation(this->T_MOD, n);
+  if (n <= 0)
+    return {{{{1, 0}}, {{0, 1}}}};
+
+  long double a = this->T_MOD[0][0], c = this->T_MOD[1][0];
+  long double a_pow = std::pow(a, (long double)(n - 1));
+
+  return {{{{a_pow * a, 0}}, {{c * a_pow, 0}}}};
+}
+
 void MarkovChain::print() const {
   std::cout << "T:";
   for (int i : {0, 1})
@@ -35,12 +75,13 @@ void MarkovChain::print() const {
 }
 
 // calculaters T transition matrix
-void MarkovChain::calculate_base_transition_matrix(long long chr_size, const std::vector<Interval> &query_intervals) {
+void MarkovChain::calculate_base_transition_matrix(long long chr_size, const std::vector<Interval> &query_intervals,
+                                                   bool query_as_bases) {
   long double L = chr_size;
-  long double len_Q = query_intervals.size();
   long double weight_Q = 0;
   for (Interval interval : query_intervals)
     weight_Q += interval.length();
+  long double len_Q = query_as_bases ? weight_Q : query_intervals.size();
 
   this->T[0][1] = (len_Q) / (L - weight_Q - 1);
   this->T[0][0] = 1 - this->T[0][1];
@@ -50,13 +91,14 @@ void MarkovChain::calculate_base_transition_matrix(long long chr_size, const std
 }
 
 // calculates T and T_mod (its just T, with zeros in second col)
-void MarkovChain::calculate_transition_matrices(long long chr_size, const std::vector<Interval> &query_intervals) {
+void MarkovChain::calculate_transition_matrices(long long chr_size, const std::vector<Interval> &query_intervals,
+                                                bool query_as_bases) {
   if (query_intervals.empty()) {
     logger.error("Query intervals should not be empty.");
     exit(1);
   }
 
-  calculate_base_transition_matrix(chr_size, query_intervals);
+  calculate_base_transition_matrix(chr_size, query_intervals, query_as_bases);
 
   this->T_MOD[0][0] = this->T[0][0];
   this->T_MOD[1][0] = this->T[1][0];
@@ -78,3 +120,13 @@ void MarkovChain::calculate_stationary_distribution() {
 
   this->stationary_distribution = {c / denom, b / denom};
 }
+
+// closed forms are only valid for a stochastic irreducible T and for T_MOD with zeroed second column
+void MarkovChain::check_closed_forms() {
+  const long double eps = 1e-12;
+  long double b = this->T[0][1], c = this->T[1][0];
+
+  this->has_closed_form_T = std::abs(this->T[0][0] + b - 1) < eps && std::abs(c + this->T[1][1] - 1) < eps &&
+                            b >= 0 && c >= 0 && b + c > 1e-9;
+  this->has_closed_form_T_MOD = this->T_MOD[0][1] == 0 && this->T_MOD[1][1] == 0;
+}
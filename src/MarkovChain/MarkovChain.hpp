@@ -13,22 +13,33 @@ public:
   MarkovChain();
   MarkovChain(TransitionMatrix T, TransitionMatrix T_MOD, StationaryDistribution stationary_distribution);
   MarkovChain(TransitionMatrix T, TransitionMatrix T_MOD);
-  MarkovChain(long long chr_len, const std::vector<Interval> &query_intervals);
+  // with `query_as_bases` every query base counts as an interval of its own, the same chain as estimated from
+  // split_intervals_into_ones(query_intervals) without materializing the bases
+  MarkovChain(long long chr_len, const std::vector<Interval> &query_intervals, bool query_as_bases = false);
 
   TransitionMatrix get_T() const;
   TransitionMatrix get_T_MOD() const;
   StationaryDistribution get_stationary_distribution() const;
 
+  // T^n and T_MOD^n in O(1) using closed forms for 2-state chains, falls back to binary exponentiation when the
+  // matrices do not have the expected shape
+  TransitionMatrix power_T(long long n) const;
+  TransitionMatrix power_T_MOD(long long n) const;
+
   void print() const;
 
 private:
   TransitionMatrix T{}, T_MOD{};
   StationaryDistribution stationary_distribution{};
+  bool has_closed_form_T = false, has_closed_form_T_MOD = false;
 
-  void calculate_base_transition_matrix(long long chr_size, const std::vector<Interval> &query_intervals);
-  void calculate_transition_matrices(long long chr_size, const std::vector<Interval> &query_intervals);
+  void calculate_base_transition_matrix(long long chr_size, const std::vector<Interval> &query_intervals,
+                                        bool query_as_bases);
+  void calculate_transition_matrices(long long chr_size, const std::vector<Interval> &query_intervals,
+                                     bool query_as_bases);
   void calculate_transition_matrices();
   void calculate_stationary_distribution();
+  void check_closed_forms();
 };
 
 #endif // MARKOVCHAIN_H
@@ -0,0 +1,266 @@
+#include "BasesModel.hpp"
+#include "../Convolution/Convolution.hpp"
+#include "../Helpers/Helpers.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <omp.h>
+
+// reference bases in one stretch, the direct evaluation of a stretch is quadratic in this
+const long long BASES_CHUNK_SIZE = 128;
+
+// below this many stretches the two halves of a product tree node are joined in the current task
+const size_t BASES_TASK_CUTOFF = 64;
+
+const long double ld_inf = std::numeric_limits<long double>::infinity();
+
+// log probabilities of covering offset, offset + 1, ... bases, all counts outside of this range have zero probability
+struct ShiftedLogprobs {
+  long long offset = 0;
+  std::vector<long double> logprobs;
+};
+
+// P[s][t] of a stretch, see BasesModel
+using StretchProbs = std::array<std::array<ShiftedLogprobs, 2>, 2>;
+
+BasesModel::BasesModel(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals,
+                       ChrSizesMap chr_sizes_map, long double epsilon)
+    : Model(std::move(ref_intervals), std::move(query_intervals), std::move(chr_sizes_map), epsilon) {}
+
+std::vector<long double> BasesModel::eval_probs_single_chr(const std::vector<Interval> &ref_intervals,
+                                                          const std::vector<Interval> &query_intervals,
+                                                          const MarkovChain &markov_chain, long long chr_size,
+                                                          long double chr_epsilon, long double &dropped_mass) {
+  return eval_probs_single_chr_bases(ref_intervals, markov_chain, chr_size, chr_epsilon, dropped_mass);
+}
+
+MarkovChain BasesModel::estimate_markov_chain(long long chr_size, const std::vector<Interval> &query_intervals) {
+  return MarkovChain(chr_size, query_intervals, true);
+}
+
+static long double log_add(long double log_x, long double log_y) {
+  if (log_x < log_y)
+    std::swap(log_x, log_y);
+  if (log_y == -ld_inf)
+    return log_x;
+  return log_x + std::log1p(std::exp(log_y - log_x));
+}
+
+// gaps[i] bases outside of the reference followed by lengths[i] reference bases, for all i in order
+static StretchProbs eval_stretch(const std::vector<long long> &gaps, const std::vector<long long> &lengths,
+                                 const MarkovChain &markov_chain) {
+  long long total_length = 0;
+  for (long long length : lengths)
+    total_length += length;
+
+  // a reference base is covered iff the chain is in state 1 on it, D moves over a base that is not covered and
+  // H = T - D over a covered one
+  TransitionMatrix D = markov_chain.get_T_MOD(), H = subtract_matrices(markov_chain.get_T(), D);
+
+  // probs[s][t][k] in linear space, stretches are short enough for long double to hold every relevant value
+  std::array<std::array<std::vector<long double>, 2>, 2> probs;
+  for (int s : {0, 1})
+    for (int t : {0, 1})
+      probs[s][t].assign(total_length + 1, 0);
+  probs[0][0][0] = probs[1][1][0] = 1;
+
+  long long degree = 0;
+  for (size_t idx = 0; idx < gaps.size(); idx++) {
+    TransitionMatrix T_gap = markov_chain.power_T(gaps[idx]);
+    for (int s : {0, 1}) {
+      std::vector<long double> &probs0 = probs[s][0], &probs1 = probs[s][1];
+      for (long long k = 0; k <= degree; k++) {
+        long double p0 = probs0[k], p1 = probs1[k];
+        probs0[k] = p0 * T_gap[0][0] + p1 * T_gap[1][0];
+        probs1[k] = p0 * T_gap[0][1] + p1 * T_gap[1][1];
+      }
+    }
+
+    for (long long base = 0; base < lengths[idx]; base++) {
+      for (int s : {0, 1}) {
+        std::vector<long double> &probs0 = probs[s][0], &probs1 = probs[s][1];
+        // going from the top, so entry k + 1 already holds its uncovered part when the covered part of k is added
+        for (long long k = degree; k >= 0; k--) {
+          long double p0 = probs0[k], p1 = probs1[k];
+          probs0[k + 1] += p0 * H[0][0] + p1 * H[1][0];
+          probs1[k + 1] += p0 * H[0][1] + p1 * H[1][1];
+          probs0[k] = p0 * D[0][0] + p1 * D[1][0];
+          probs1[k] = p0 * D[0][1] + p1 * D[1][1];
+        }
+      }
+      degree++;
+    }
+  }
+  // every covered base updates degree + 1 counts for both starting states
+  profiler.count(Counter::DP_CELLS, total_length * (total_length + 1));
+
+  StretchProbs stretch;
+  for (int s : {0, 1}) {
+    for (int t : {0, 1}) {
+      stretch[s][t].logprobs.resize(total_length + 1);
+      for (long long k = 0; k <= total_length; k++)
+        stretch[s][t].logprobs[k] = std::log(probs[s][t][k]);
+    }
+  }
+  return stretch;
+}
+
+// removes entries from both ends of every generating function while their mass fits into a quarter of the budget.
+// whatever happens before and after a stretch multiplies its probabilities by at most one, so the result loses at most
+// the returned mass. entries with zero probability at the ends are removed even without budget
+static long double trim_tails(StretchProbs &stretch, long double budget) {
+  long double dropped_mass = 0;
+
+  for (int s : {0, 1}) {
+    for (int t : {0, 1}) {
+      std::vector<long double> &logprobs = stretch[s][t].logprobs;
+      long double left_budget = budget / 4;
+      size_t lo = 0, hi = logprobs.size();
+      while (lo < hi && std::exp(logprobs[lo]) <= left_budget) {
+        left_budget -= std::exp(logprobs[lo]);
+        dropped_mass += std::exp(logprobs[lo++]);
+      }
+      while (hi > lo && std::exp(logprobs[hi - 1]) <= left_budget) {
+        left_budget -= std::exp(logprobs[hi - 1]);
+        dropped_mass += std::exp(logprobs[--hi]);
+      }
+
+      logprobs.erase(logprobs.begin() + hi, logprobs.end());
+      logprobs.erase(logprobs.begin(), logprobs.begin() + lo);
+      stretch[s][t].offset += lo;
+    }
+  }
+
+  return dropped_mass;
+}
+
+// result[s][t] = sum over u of left[s][u] * right[u][t], where * is the convolution of generating functions
+static StretchProbs multiply_stretches(const StretchProbs &left, const StretchProbs &right) {
+  StretchProbs result;
+
+  for (int s : {0, 1}) {
+    for (int t : {0, 1}) {
+      ShiftedLogprobs products[2];
+      long long begin = std::numeric_limits<long long>::max(), end = std::numeric_limits<long long>::min();
+      for (int u : {0, 1}) {
+        products[u].offset = left[s][u].offset + right[u][t].offset;
+        products[u].logprobs = convolve_logprobs(left[s][u].logprobs, right[u][t].logprobs);
+        if (!products[u].logprobs.empty()) {
+          begin = std::min(begin, products[u].offset);
+          end = std::max(end, products[u].offset + (long long)products[u].logprobs.size());
+        }
+      }
+
+      if (begin >= end)
+        continue;
+      result[s][t].offset = begin;
+      result[s][t].logprobs.assign(end - begin, -ld_inf);
+      for (const ShiftedLogprobs &product : products)
+        for (size_t idx = 0; idx < product.logprobs.size(); idx++) {
+          long double &entry = result[s][t].logprobs[product.offset - begin + idx];
+          entry = log_add(entry, product.logprobs[idx]);
+        }
+    }
+  }
+
+  return result;
+}
+
+// joins stretches[lo, hi) as a balanced binary tree, the two halves of each node are computed as separate tasks.
+// every joined node is trimmed with `node_budget`
+static StretchProbs join_stretches(const std::vector<StretchProbs> &stretches, size_t lo, size_t hi,
+                                   long double node_budget, long double &dropped_mass) {
+  if (hi - lo == 1)
+    return stretches[lo];
+
+  size_t mid = (lo + hi) / 2;
+  StretchProbs left, right;
+  long double left_dropped_mass = 0, right_dropped_mass = 0;
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp task shared(left, left_dropped_mass) if (hi - lo > BASES_TASK_CUTOFF)
+  {
+    ProfileScope scope(context);
+    left = join_stretches(stretches, lo, mid, node_budget, left_dropped_mass);
+  }
+  right = join_stretches(stretches, mid, hi, node_budget, right_dropped_mass);
+#pragma omp taskwait
+
+  StretchProbs joined = multiply_stretches(left, right);
+  dropped_mass += left_dropped_mass + right_dropped_mass + trim_tails(joined, node_budget);
+  return joined;
+}
+
+std::vector<long double> BasesModel::eval_probs_single_chr_bases(std::vector<Interval> ref_intervals,
+                                                                 const MarkovChain &markov_chain, long long chr_size,
+                                                                 long double epsilon, long double &dropped_mass) {
+  move_ref_intervals_off_zero(ref_intervals);
+
+  // runs longer than the space left in a stretch continue in the next one with an empty gap
+  std::vector<std::vector<long long>> stretch_gaps(1), stretch_lengths(1);
+  long long stretch_bases = 0, prev_end = 0, total_bases = 0;
+  for (const Interval &interval : ref_intervals) {
+    long long gap = interval.begin - prev_end;
+    if (gap < 0) {
+      logger.error("Gap should be non-negative.");
+      exit(1);
+    }
+
+    for (long long pos = interval.begin; pos < interval.end;) {
+      if (stretch_bases == BASES_CHUNK_SIZE) {
+        stretch_gaps.emplace_back();
+        stretch_lengths.emplace_back();
+        stretch_bases = 0;
+      }
+      long long length = std::min(interval.end - pos, BASES_CHUNK_SIZE - stretch_bases);
+      stretch_gaps.back().push_back(gap);
+      stretch_lengths.back().push_back(length);
+      gap = 0;
+      pos += length;
+      stretch_bases += length;
+    }
+    prev_end = interval.end;
+    total_bases += interval.end - interval.begin;
+  }
+  stretch_gaps.back().push_back(chr_size - prev_end);
+  stretch_lengths.back().push_back(0);
+
+  // the product tree has 2 * stretches - 1 nodes, each gets the same share of epsilon
+  std::vector<StretchProbs> stretches(stretch_gaps.size());
+  std::vector<long double> stretch_dropped_mass(stretches.size());
+  long double node_budget = epsilon / (2 * stretches.size() - 1);
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp parallel for schedule(dynamic)
+  for (size_t idx = 0; idx < stretches.size(); idx++) {
+    ProfileScope scope(context);
+    stretches[idx] = eval_stretch(stretch_gaps[idx], stretch_lengths[idx], markov_chain);
+    stretch_dropped_mass[idx] = trim_tails(stretches[idx], node_budget);
+  }
+  for (long double stretch_mass : stretch_dropped_mass)
+    dropped_mass += stretch_mass;
+
+  StretchProbs joined;
+#pragma omp parallel
+#pragma omp single
+  {
+    ProfileScope scope(context);
+    joined = join_stretches(stretches, 0, stretches.size(), node_budget, dropped_mass);
+  }
+
+  StationaryDistribution stationary_distribution = markov_chain.get_stationary_distribution();
+  std::vector<long double> probs(total_bases + 1, -ld_inf);
+  for (int s : {0, 1}) {
+    for (int t : {0, 1}) {
+      const ShiftedLogprobs &shifted = joined[s][t];
+      for (size_t idx = 0; idx < shifted.logprobs.size(); idx++) {
+        long double &entry = probs[shifted.offset + idx];
+        entry = log_add(entry, std::log(stationary_distribution[s]) + shifted.logprobs[idx]);
+      }
+    }
+  }
+
+  return probs;
+}
@@ -0,0 +1,37 @@
+#ifndef BASESMODEL_H
+#define BASESMODEL_H
+
+#include "../Interval/Interval.hpp"
+#include "../MarkovChain/MarkovChain.hpp"
+#include "Model.hpp"
+
+#include <vector>
+
+// model for the bases statistic, the number of reference bases covered by the query.
+// every reference interval is a run of bases, no interval is split into single bases. the DP state of a stretch of the
+// chromosome is the 2x2 matrix of generating functions P[s][t][k], probability of ending in state t with k covered
+// bases when starting in state s. stretches of at most BASES_CHUNK_SIZE reference bases are evaluated with the
+// transfer matrix of one base and the stretches are joined in a product tree of log space convolutions
+class BasesModel : public Model {
+public:
+  BasesModel(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map,
+             long double epsilon = 0);
+
+  // if epsilon is positive, every node of the product tree drops tails holding at most its share of epsilon, which
+  // keeps the convolutions proportional to the spread of the distribution instead of the number of reference bases.
+  // the actual dropped mass is added to `dropped_mass`
+  static std::vector<long double> eval_probs_single_chr_bases(std::vector<Interval> ref_intervals,
+                                                              const MarkovChain &markov_chain, long long chr_size,
+                                                              long double epsilon, long double &dropped_mass);
+
+protected:
+  // the chain of single query bases, as in the window models and in the DP over single bases
+  MarkovChain estimate_markov_chain(long long chr_size, const std::vector<Interval> &query_intervals) override;
+
+  std::vector<long double> eval_probs_single_chr(const std::vector<Interval> &ref_intervals,
+                                                 const std::vector<Interval> &query_intervals,
+                                                 const MarkovChain &markov_chain, long long chr_size,
+                                                 long double chr_epsilon, long double &dropped_mass) override;
+};
+
+#endif // BASESMODEL_H
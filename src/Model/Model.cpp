@@ -1,66 +1,111 @@
 #include "Model.hpp"
 #include "../Helpers/Helpers.hpp"
+#include "../Interval/ChrDictionary.hpp"
 #include "../Logger/Logger.hpp"
 #include "../MarkovChain/MarkovChain.hpp"
+#include "../ParallelSort/ParallelSort.hpp"
+#include "../Profiler/Profiler.hpp"
+#include "../ScaledColumn/ScaledColumn.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <omp.h>
+#include <unordered_map>
 
 Model::Model() : ref_intervals(), query_intervals(), chr_sizes() {}
 
-Model::Model(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map)
-    : ref_intervals(ref_intervals), query_intervals(query_intervals) {
-  sort(ref_intervals.begin(), ref_intervals.end());
-  sort(query_intervals.begin(), query_intervals.end());
+Model::Model(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map,
+             long double epsilon)
+    : ref_intervals(std::move(ref_intervals)), query_intervals(std::move(query_intervals)), epsilon(epsilon) {
+  // intervals from preprocess_intervals are already sorted
+  if (!std::is_sorted(this->ref_intervals.begin(), this->ref_intervals.end()))
+    sort_intervals(this->ref_intervals);
+  if (!std::is_sorted(this->query_intervals.begin(), this->query_intervals.end()))
+    sort_intervals(this->query_intervals);
   chr_sizes = chr_sizes_map_to_array(chr_sizes_map);
   sort(chr_sizes.begin(), chr_sizes.end());
 
-  prob_method = Model::eval_probs_single_chr_direct;
+  prob_method = Model::eval_probs_single_chr_scaled;
 }
 
-std::vector<Interval> Model::select_intervals_by_chr_name(std::vector<Interval> &intervals, size_t &intervals_idx,
-                                                          std::string chr_name) {
-  std::vector<Interval> chr_intervals;
-  for (; intervals_idx < intervals.size() && intervals[intervals_idx].chr_name <= chr_name; intervals_idx++)
-    if (intervals[intervals_idx].chr_name == chr_name)
-      chr_intervals.push_back(intervals[intervals_idx]);
-  return chr_intervals;
+std::vector<std::vector<Interval>> Model::split_intervals_by_chr(const std::vector<Interval> &intervals,
+                                                                 const ChrSizesVector &chr_sizes) {
+  std::unordered_map<uint32_t, size_t> chr_idx_by_id;
+  for (size_t chr_sizes_idx = 0; chr_sizes_idx < chr_sizes.size(); chr_sizes_idx++)
+    chr_idx_by_id[ChrDictionary::get_id(chr_sizes[chr_sizes_idx].first)] = chr_sizes_idx;
+
+  std::vector<std::vector<Interval>> intervals_by_chr(chr_sizes.size());
+  for (const Interval &interval : intervals) {
+    auto it = chr_idx_by_id.find(interval.chr_id);
+    if (it != chr_idx_by_id.end())
+      intervals_by_chr[it->second].push_back(interval);
+  }
+  return intervals_by_chr;
 }
 
 std::vector<long double> Model::eval_probs(long long overlap_count) {
   std::vector<std::vector<long double>> probs_by_chr(chr_sizes.size());
-  std::vector<std::vector<Interval>> ref_intervals_by_chr(chr_sizes.size()), query_intervals_by_chr(chr_sizes.size());
-
-  size_t ref_idx = 0, query_idx = 0;
-  for (size_t chr_sizes_idx = 0; chr_sizes_idx < chr_sizes.size(); chr_sizes_idx++) {
-    std::string chr_name = chr_sizes[chr_sizes_idx].first;
-
-    ref_intervals_by_chr[chr_sizes_idx] = Model::select_intervals_by_chr_name(ref_intervals, ref_idx, chr_name),
-    query_intervals_by_chr[chr_sizes_idx] = Model::select_intervals_by_chr_name(query_intervals, query_idx, chr_name);
-  }
+  std::vector<long double> dropped_mass_by_chr(chr_sizes.size());
+  ProfileScope preprocessing_scope(Phase::PREPROCESSING);
+  std::vector<std::vector<Interval>> ref_intervals_by_chr = Model::split_intervals_by_chr(ref_intervals, chr_sizes),
+                                     query_intervals_by_chr = Model::split_intervals_by_chr(query_intervals, chr_sizes);
+  preprocessing_scope.stop();
+
+  // the dropped masses of the chromosomes add up, so epsilon is split among the chromosomes that run a DP
+  size_t evaluated_ref_count = 0;
+  for (size_t chr_sizes_idx = 0; chr_sizes_idx < chr_sizes.size(); chr_sizes_idx++)
+    if (!query_intervals_by_chr[chr_sizes_idx].empty())
+      evaluated_ref_count += ref_intervals_by_chr[chr_sizes_idx].size();
 
 // sometimes turned off for debugging
 #pragma omp parallel for
   for (size_t chr_sizes_idx = 0; chr_sizes_idx < chr_sizes.size(); chr_sizes_idx++) {
     std::vector<long double> probs(1);
     if (!query_intervals_by_chr[chr_sizes_idx].empty()) {
+      uint32_t chr_id = ChrDictionary::get_id(chr_sizes[chr_sizes_idx].first);
       long long chr_size = chr_sizes[chr_sizes_idx].second;
-      MarkovChain markov_chain(chr_size, query_intervals_by_chr[chr_sizes_idx]);
-      probs = prob_method(ref_intervals_by_chr[chr_sizes_idx], query_intervals_by_chr[chr_sizes_idx], markov_chain,
-                          chr_size);
+      ProfileScope markov_chain_scope(Phase::MARKOV_CHAIN, chr_id);
+      MarkovChain markov_chain = estimate_markov_chain(chr_size, query_intervals_by_chr[chr_sizes_idx]);
+      markov_chain_scope.stop();
+
+      long double chr_epsilon =
+          evaluated_ref_count ? epsilon * ref_intervals_by_chr[chr_sizes_idx].size() / evaluated_ref_count : 0;
+      ProfileScope dp_scope(Phase::CHROMOSOME_DP, chr_id);
+      probs = eval_probs_single_chr(ref_intervals_by_chr[chr_sizes_idx], query_intervals_by_chr[chr_sizes_idx],
+                                    markov_chain, chr_size, chr_epsilon, dropped_mass_by_chr[chr_sizes_idx]);
     }
     probs_by_chr[chr_sizes_idx] = probs;
   }
 
+  if (epsilon > 0) {
+    dropped_mass = 0;
+    for (long double chr_dropped_mass : dropped_mass_by_chr)
+      dropped_mass += chr_dropped_mass;
+    logger.info("Truncated DP dropped " + to_string(dropped_mass) +
+                " of probability mass, p-values are accurate up to this error.");
+  }
+
+  // the per chromosome distributions are merged as a product tree, whose subtrees run as OpenMP tasks
+  ProfileScope joint_probs_scope(Phase::JOINT_PROBS);
   return joint_logprobs(probs_by_chr);
 }
 
-std::vector<long double> Model::eval_probs_single_chr_direct(std::vector<Interval> ref_intervals,
-                                                             std::vector<Interval> query_intervals,
-                                                             const MarkovChain &markov_chain, long long chr_size) {
-  int m = ref_intervals.size();
-  if (m && ref_intervals[0].begin == 0) {
+MarkovChain Model::estimate_markov_chain(long long chr_size, const std::vector<Interval> &query_intervals) {
+  return MarkovChain(chr_size, query_intervals);
+}
+
+std::vector<long double> Model::eval_probs_single_chr(const std::vector<Interval> &ref_intervals,
+                                                     const std::vector<Interval> &query_intervals,
+                                                     const MarkovChain &markov_chain, long long chr_size,
+                                                     long double chr_epsilon, long double &dropped_mass) {
+  if (chr_epsilon > 0)
+    return eval_probs_single_chr_banded(ref_intervals, markov_chain, chr_size, chr_epsilon, dropped_mass);
+  return prob_method(ref_intervals, query_intervals, markov_chain, chr_size);
+}
+
+void Model::move_ref_intervals_off_zero(std::vector<Interval> &ref_intervals) {
+  if (!ref_intervals.empty() && ref_intervals[0].begin == 0) {
     logger.warn("First reference interval starts with zero, changing to one!");
     ref_intervals[0].begin = 1;
     if (ref_intervals[0].end - ref_intervals[0].begin == 0) {
@@ -68,21 +113,24 @@ std::vector<long double> Model::eval_probs_single_chr_direct(std::vector<Interva
       ref_intervals.erase(ref_intervals.begin());
     }
   }
+}
 
+std::vector<Interval> Model::augment_ref_intervals(const std::vector<Interval> &ref_intervals, long long chr_size) {
   std::vector<Interval> ref_intervals_augmented;
+  ref_intervals_augmented.reserve(ref_intervals.size() + 2);
   ref_intervals_augmented.push_back(Interval("", std::numeric_limits<long long>::min(), 0));
   extend(ref_intervals_augmented, ref_intervals);
   ref_intervals_augmented.push_back(Interval("", chr_size, std::numeric_limits<long long>::max()));
+  return ref_intervals_augmented;
+}
 
-  std::vector<std::array<long double, 2>> prev_line(m + 1, std::array<long double, 2>()),
-      last_col(m + 1, std::array<long double, 2>());
-  // prev_line[0][0] = 1;
-  StationaryDistribution stationary_distribution = markov_chain.get_stationary_distribution();
-  prev_line[0][0] = stationary_distribution[0];
-  prev_line[0][1] = stationary_distribution[1];
+// precomputes the matrices for every (gap, interval) pair once, so each DP cell is just two 2x2 products
+TransitionPowers Model::get_transition_powers(const std::vector<Interval> &ref_intervals_augmented,
+                                              const MarkovChain &markov_chain) {
+  size_t m = ref_intervals_augmented.size() - 2;
+  TransitionPowers powers{std::vector<TransitionMatrix>(m + 1), std::vector<TransitionMatrix>(m + 1)};
 
-  // calculate zero-th row in separate way
-  for (int j = 1; j <= m; j++) {
+  for (size_t j = 1; j <= m; j++) {
     long long gap = ref_intervals_augmented[j].begin - ref_intervals_augmented[j - 1].end;
     if (gap < 0) {
       logger.error("Gap should be non-negative.");
@@ -95,9 +143,38 @@ std::vector<long double> Model::eval_probs_single_chr_direct(std::vector<Interva
       exit(1);
     }
 
-    std::array<std::array<long double, 2>, 2> result = matrix_multiply(
-        {{prev_line[j - 1], {{}}}}, matrix_multiply(binary_exponentiation(markov_chain.get_T(), gap),
-                                                    binary_exponentiation(markov_chain.get_T_MOD(), len)));
+    TransitionMatrix T_gap = markov_chain.power_T(gap);
+    TransitionMatrix T_len = markov_chain.power_T(len);
+    TransitionMatrix D_len = markov_chain.power_T_MOD(len);
+
+    powers.dont_hit[j] = matrix_multiply(T_gap, D_len);
+    powers.hit[j] = matrix_multiply(T_gap, subtract_matrices(T_len, D_len));
+  }
+
+  return powers;
+}
+
+std::vector<long double> Model::eval_probs_single_chr_direct(std::vector<Interval> ref_intervals,
+                                                             std::vector<Interval> query_intervals,
+                                                             const MarkovChain &markov_chain, long long chr_size) {
+  move_ref_intervals_off_zero(ref_intervals);
+  int m = ref_intervals.size();
+
+  std::vector<Interval> ref_intervals_augmented = augment_ref_intervals(ref_intervals, chr_size);
+
+  std::vector<std::array<long double, 2>> prev_line(m + 1, std::array<long double, 2>()),
+      last_col(m + 1, std::array<long double, 2>());
+  // prev_line[0][0] = 1;
+  StationaryDistribution stationary_distribution = markov_chain.get_stationary_distribution();
+  prev_line[0][0] = stationary_distribution[0];
+  prev_line[0][1] = stationary_distribution[1];
+
+  TransitionPowers powers = get_transition_powers(ref_intervals_augmented, markov_chain);
+  profiler.count(Counter::DP_CELLS, (long long)(m + 1) * (m + 2) / 2);
+
+  // calculate zero-th row in separate way
+  for (int j = 1; j <= m; j++) {
+    std::array<std::array<long double, 2>, 2> result = matrix_multiply({{prev_line[j - 1], {{}}}}, powers.dont_hit[j]);
     prev_line[j] = result[0];
   }
 
@@ -112,28 +189,11 @@ std::vector<long double> Model::eval_probs_single_chr_direct(std::vector<Interva
     }
 
     for (int j = k; j <= m; j++) {
-      long long gap = ref_intervals_augmented[j].begin - ref_intervals_augmented[j - 1].end;
-      if (gap < 0) {
-        logger.error("Gap should be non-negative.");
-        exit(1);
-      }
-
-      long long len = ref_intervals_augmented[j].end - ref_intervals_augmented[j].begin;
-      if (len < 0) {
-        logger.error("Interval length should be non-negative.");
-        exit(1);
-      }
-
       // dont_hit = P[j-1, k] * T^gap * D^len
-      std::array<std::array<long double, 2>, 2> dont_hit = matrix_multiply(
-          {{next_line[j - 1], {{}}}}, matrix_multiply(binary_exponentiation(markov_chain.get_T(), gap),
-                                                      binary_exponentiation(markov_chain.get_T_MOD(), len)));
+      std::array<std::array<long double, 2>, 2> dont_hit =
+          matrix_multiply({{next_line[j - 1], {{}}}}, powers.dont_hit[j]);
       // hit = P[j-1, k-1] * T^gap * (T^len - D^l)
-      std::array<std::array<long double, 2>, 2> hit =
-          matrix_multiply({{prev_line[j - 1], {{}}}},
-                          matrix_multiply(binary_exponentiation(markov_chain.get_T(), gap),
-                                          subtract_matrices(binary_exponentiation(markov_chain.get_T(), len),
-                                                            binary_exponentiation(markov_chain.get_T_MOD(), len))));
+      std::array<std::array<long double, 2>, 2> hit = matrix_multiply({{prev_line[j - 1], {{}}}}, powers.hit[j]);
 
       // P[j,k] = dont_hit + hit
       next_line[j] = add_matrices(dont_hit, hit)[0];
@@ -145,105 +205,144 @@ std::vector<long double> Model::eval_probs_single_chr_direct(std::vector<Interva
   }
 
   std::vector<long double> probs(m + 1);
+  long long trailing_gap = chr_size - ref_intervals_augmented[m].end;
+  TransitionMatrix T_trailing_gap = markov_chain.power_T(trailing_gap);
   for (int k = 0; k <= m; k++) {
-    long long trailing_gap = chr_size - ref_intervals_augmented[m].end;
-    last_col[k] = matrix_multiply({{last_col[k], {{}}}}, binary_exponentiation(markov_chain.get_T(), trailing_gap))[0];
+    last_col[k] = matrix_multiply({{last_col[k], {{}}}}, T_trailing_gap)[0];
     probs[k] = log(last_col[k][0] + last_col[k][1]);
   }
 
   return probs;
 }
 
-std::array<std::array<std::vector<long double>, 2>, 2>
-Model::eval_probs_single_chr_direct_new(const std::vector<Interval> &ref_intervals, long long window_start,
-                                        long long window_end, const MarkovChain &markov_chain) {
+// same recurrence as eval_probs_single_chr_direct, computed column by column with a separate exponent for every overlap
+// count (see ScaledColumn). runs in double and falls back to long double only if the double column is not precise
+std::vector<long double> Model::eval_probs_single_chr_scaled(std::vector<Interval> ref_intervals,
+                                                             std::vector<Interval> query_intervals,
+                                                             const MarkovChain &markov_chain, long long chr_size) {
+  move_ref_intervals_off_zero(ref_intervals);
   int m = ref_intervals.size();
-  std::vector<Interval> ref_intervals_augmented;
-  ref_intervals_augmented.push_back(Interval("", std::numeric_limits<long long>::min(), window_start));
-  extend(ref_intervals_augmented, ref_intervals);
-  ref_intervals_augmented.push_back(Interval("", window_end, std::numeric_limits<long long>::max()));
 
-  std::array<std::array<std::vector<long double>, 2>, 2> probs{};
-  for (int start_state : {0, 1}) {
-    std::vector<std::array<long double, 2>> prev_line(m + 1, std::array<long double, 2>{}),
-        last_col(m + 1, std::array<long double, 2>{});
-    prev_line[0][start_state] = 1;
-
-    // calculate zero-th row in separate way
-    for (int j = 1; j <= m; j++) {
-      long long gap = ref_intervals_augmented[j].begin - ref_intervals_augmented[j - 1].end;
-      if (gap < 0) {
-        logger.error("Gap should be non-negative.");
-        exit(1);
-      }
+  std::vector<Interval> ref_intervals_augmented = augment_ref_intervals(ref_intervals, chr_size);
 
-      long long len = ref_intervals_augmented[j].end - ref_intervals_augmented[j].begin;
-      if (len < 0) {
-        logger.error("Interval length should be non-negative.");
-        exit(1);
-      }
+  TransitionPowers powers = get_transition_powers(ref_intervals_augmented, markov_chain);
 
-      std::array<std::array<long double, 2>, 2> result = matrix_multiply(
-          {{prev_line[j - 1], {{}}}}, matrix_multiply(binary_exponentiation(markov_chain.get_T(), gap),
-                                                      binary_exponentiation(markov_chain.get_T_MOD(), len)));
-      prev_line[j] = result[0];
-    }
+  long long trailing_gap = chr_size - ref_intervals_augmented[m].end;
+  TransitionMatrix T_trailing_gap = markov_chain.power_T(trailing_gap);
+  profiler.count(Counter::DP_CELLS, (long long)(m + 1) * (m + 2) / 2);
 
-    last_col[0] = prev_line[prev_line.size() - 1];
+  return eval_with_adaptive_precision(m, markov_chain.get_stationary_distribution(), [&](auto &col) {
+    for (int j = 1; j <= m; j++)
+      col.advance(powers.dont_hit[j], powers.hit[j]);
 
-    std::vector<std::array<long double, 2>> next_line(m + 1, std::array<long double, 2>{});
-    for (int k = 1; k <= m; k++) {
-      next_line[k - 1] = {0, 0};
+    std::vector<long double> probs(m + 1);
+    for (int k = 0; k <= m; k++)
+      probs[k] = col.log_prob(k, T_trailing_gap);
+    return probs;
+  });
+}
 
-      if (k % 500 == 0) {
-        logger.debug("Processing " + std::to_string(k) + "-th line out of " + std::to_string(m) +
-                     " rows of DP table...");
-      }
+// same recurrence as eval_probs_single_chr_direct, but computed column by column (one reference interval at a time)
+// and only for the band of overlap counts [lo, hi] that still holds non-negligible probability mass.
+// after each column the band is shrunk from both sides while the dropped mass fits into epsilon / m, so at most
+// epsilon of the mass of this chromosome is lost, the actual amount is added to `dropped_mass`. eval_probs hands
+// every chromosome its share of the genome-wide epsilon
+std::vector<long double> Model::eval_probs_single_chr_banded(std::vector<Interval> ref_intervals,
+                                                             const MarkovChain &markov_chain, long long chr_size,
+                                                             long double epsilon, long double &dropped_mass) {
+  move_ref_intervals_off_zero(ref_intervals);
+  int m = ref_intervals.size();
 
-      for (int j = k; j <= m; j++) {
-        long long gap = ref_intervals_augmented[j].begin - ref_intervals_augmented[j - 1].end;
-        if (gap < 0) {
-          logger.error("Gap should be non-negative.");
-          exit(1);
-        }
-
-        long long len = ref_intervals_augmented[j].end - ref_intervals_augmented[j].begin;
-        if (len < 0) {
-          logger.error("Interval length should be non-negative.");
-          exit(1);
-        }
-
-        // dont_hit = P[j-1, k] * T^gap * D^len
-        std::array<std::array<long double, 2>, 2> dont_hit = matrix_multiply(
-            {{next_line[j - 1], {{}}}}, matrix_multiply(binary_exponentiation(markov_chain.get_T(), gap),
-                                                        binary_exponentiation(markov_chain.get_T_MOD(), len)));
-        // hit = P[j-1, k-1] * T^gap * (T^len - D^l)
-        std::array<std::array<long double, 2>, 2> hit =
-            matrix_multiply({{prev_line[j - 1], {{}}}},
-                            matrix_multiply(binary_exponentiation(markov_chain.get_T(), gap),
-                                            subtract_matrices(binary_exponentiation(markov_chain.get_T(), len),
-                                                              binary_exponentiation(markov_chain.get_T_MOD(), len))));
-
-        // P[j,k] = dont_hit + hit
-        next_line[j] = add_matrices(dont_hit, hit)[0];
-      }
+  std::vector<Interval> ref_intervals_augmented = augment_ref_intervals(ref_intervals, chr_size);
+
+  TransitionPowers powers = get_transition_powers(ref_intervals_augmented, markov_chain);
 
-      last_col[k] = next_line[next_line.size() - 1];
+  // col[k] = P[j, k] for the current column j, only entries in [lo, hi] are valid
+  std::vector<std::array<long double, 2>> col(m + 1, std::array<long double, 2>{});
+  StationaryDistribution stationary_distribution = markov_chain.get_stationary_distribution();
+  col[0] = {stationary_distribution[0], stationary_distribution[1]};
+  int lo = 0, hi = 0;
 
-      prev_line = next_line;
+  long double step_budget = m ? epsilon / m : 0;
+  long long dp_cells = 1;
+  for (int j = 1; j <= m; j++) {
+    // going from the top so col[k - 1] still holds the previous column
+    int new_hi = std::min(hi + 1, m);
+    dp_cells += new_hi - lo + 1;
+    for (int k = new_hi; k >= lo; k--) {
+      std::array<long double, 2> cell{};
+      if (k <= hi)
+        cell = matrix_multiply({{col[k], {{}}}}, powers.dont_hit[j])[0];
+      if (k > lo) {
+        std::array<long double, 2> hit = matrix_multiply({{col[k - 1], {{}}}}, powers.hit[j])[0];
+        cell = {cell[0] + hit[0], cell[1] + hit[1]};
+      }
+      col[k] = cell;
     }
+    hi = new_hi;
 
-    std::array<std::vector<long double>, 2> cur_probs = {std::vector<long double>(m + 1),
-                                                         std::vector<long double>(m + 1)};
-    for (int k = 0; k <= m; k++) {
-      // length of gap from end of last interval to end of window
-      long long trailing_gap = window_end - ref_intervals_augmented[m].end;
-      std::array<long double, 2> actual_last_col =
-          matrix_multiply({{last_col[k], {{}}}}, binary_exponentiation(markov_chain.get_T(), trailing_gap))[0];
-      for (int ending_state : {0, 1})
-        cur_probs[ending_state][k] = log(actual_last_col[ending_state]);
+    long double budget = step_budget;
+    while (lo < hi && col[lo][0] + col[lo][1] <= budget) {
+      budget -= col[lo][0] + col[lo][1];
+      dropped_mass += col[lo][0] + col[lo][1];
+      col[lo++] = {0, 0};
     }
-    probs[start_state] = cur_probs;
+    while (hi > lo && col[hi][0] + col[hi][1] <= budget) {
+      budget -= col[hi][0] + col[hi][1];
+      dropped_mass += col[hi][0] + col[hi][1];
+      col[hi--] = {0, 0};
+    }
+  }
+
+  profiler.count(Counter::DP_CELLS, dp_cells);
+
+  const long double ld_inf = std::numeric_limits<long double>::infinity();
+  std::vector<long double> probs(m + 1, -ld_inf);
+  long long trailing_gap = chr_size - ref_intervals_augmented[m].end;
+  TransitionMatrix T_trailing_gap = markov_chain.power_T(trailing_gap);
+  for (int k = lo; k <= hi; k++) {
+    std::array<long double, 2> last = matrix_multiply({{col[k], {{}}}}, T_trailing_gap)[0];
+    probs[k] = log(last[0] + last[1]);
+  }
+
+  return probs;
+}
+
+std::array<std::array<std::vector<long double>, 2>, 2>
+Model::eval_probs_single_chr_direct_new(const std::vector<Interval> &ref_intervals, long long window_start,
+                                        long long window_end, const MarkovChain &markov_chain) {
+  int m = ref_intervals.size();
+  std::vector<Interval> ref_intervals_augmented;
+  ref_intervals_augmented.push_back(Interval("", std::numeric_limits<long long>::min(), window_start));
+  extend(ref_intervals_augmented, ref_intervals);
+  ref_intervals_augmented.push_back(Interval("", window_end, std::numeric_limits<long long>::max()));
+
+  TransitionPowers powers = get_transition_powers(ref_intervals_augmented, markov_chain);
+
+  // length of gap from end of last interval to end of window
+  long long trailing_gap = window_end - ref_intervals_augmented[m].end;
+  TransitionMatrix T_trailing_gap = markov_chain.power_T(trailing_gap);
+
+  // one DP per starting state
+  profiler.count(Counter::DP_CELLS, (long long)(m + 1) * (m + 2));
+
+  std::array<std::array<std::vector<long double>, 2>, 2> probs{};
+  for (int start_state : {0, 1}) {
+    std::array<long double, 2> initial{};
+    initial[start_state] = 1;
+    probs[start_state] = eval_with_adaptive_precision(m, initial, [&](auto &col) {
+      for (int j = 1; j <= m; j++)
+        col.advance(powers.dont_hit[j], powers.hit[j]);
+
+      std::array<std::vector<long double>, 2> cur_probs = {std::vector<long double>(m + 1),
+                                                           std::vector<long double>(m + 1)};
+      for (int k = 0; k <= m; k++) {
+        std::array<long double, 2> state_probs = col.log_state_probs(k, T_trailing_gap);
+        for (int ending_state : {0, 1})
+          cur_probs[ending_state][k] = state_probs[ending_state];
+      }
+      return cur_probs;
+    });
   }
 
   return probs;
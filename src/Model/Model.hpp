@@ -8,30 +8,70 @@
 #include <functional>
 #include <vector>
 
+// per reference interval transition matrices used in the DP, indexed the same way as the augmented reference intervals
+// dont_hit[j] = T^gap * D^len and hit[j] = T^gap * (T^len - D^len), where gap precedes and len is the length of j-th
+struct TransitionPowers {
+  std::vector<TransitionMatrix> dont_hit, hit;
+};
+
 class Model {
 public:
   std::vector<Interval> ref_intervals, query_intervals;
   ChrSizesVector chr_sizes;
+  // if positive, the DPs of all chromosomes together drop at most this much probability mass. every chromosome gets a
+  // share proportional to its reference intervals (see eval_probs_single_chr_banded)
+  long double epsilon = 0;
+  // upper bound on the probability mass dropped by the truncated DP in the last eval_probs call
+  long double dropped_mass = 0;
 
   using ProbMethod =
       std::function<std::vector<long double>(std::vector<Interval>, std::vector<Interval>, MarkovChain, long long)>;
   ProbMethod prob_method;
 
   Model();
-  Model(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map);
+  Model(std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map,
+        long double epsilon = 0);
+  virtual ~Model() = default;
 
   std::vector<long double> eval_probs(long long overlap_count);
 
   static std::vector<long double> eval_probs_single_chr_direct(std::vector<Interval> ref_intervals,
                                                                std::vector<Interval> query_intervals,
                                                                const MarkovChain &markov_chain, long long chr_size);
+  static std::vector<long double> eval_probs_single_chr_scaled(std::vector<Interval> ref_intervals,
+                                                               std::vector<Interval> query_intervals,
+                                                               const MarkovChain &markov_chain, long long chr_size);
+  static std::vector<long double> eval_probs_single_chr_banded(std::vector<Interval> ref_intervals,
+                                                               const MarkovChain &markov_chain, long long chr_size,
+                                                               long double epsilon, long double &dropped_mass);
   static std::array<std::array<std::vector<long double>, 2>, 2>
   eval_probs_single_chr_direct_new(const std::vector<Interval> &ref_intervals, long long window_start,
                                    long long window_end, const MarkovChain &markov_chain);
 
 protected:
-  static std::vector<Interval> select_intervals_by_chr_name(std::vector<Interval> &intervals, size_t &intervals_idx,
-                                                            std::string chr_name);
+  // distribution of a single chromosome, uses the banded DP if its share of epsilon is positive and prob_method
+  // otherwise
+  virtual std::vector<long double> eval_probs_single_chr(const std::vector<Interval> &ref_intervals,
+                                                         const std::vector<Interval> &query_intervals,
+                                                         const MarkovChain &markov_chain, long long chr_size,
+                                                         long double chr_epsilon, long double &dropped_mass);
+
+  // query chain of a single chromosome, estimated from its query intervals
+  virtual MarkovChain estimate_markov_chain(long long chr_size, const std::vector<Interval> &query_intervals);
+
+  // the DPs start in the base before the chromosome, so the first reference interval can't start at zero. such an
+  // interval is moved to start at one and removed if that leaves it empty
+  static void move_ref_intervals_off_zero(std::vector<Interval> &ref_intervals);
+
+  // reference intervals between two sentinels, one ending at zero and one starting at the chromosome end
+  static std::vector<Interval> augment_ref_intervals(const std::vector<Interval> &ref_intervals, long long chr_size);
+
+  static TransitionPowers get_transition_powers(const std::vector<Interval> &ref_intervals_augmented,
+                                                const MarkovChain &markov_chain);
+
+  // intervals of every chromosome in chr_sizes, in the same order as chr_sizes, sorted input stays sorted
+  static std::vector<std::vector<Interval>> split_intervals_by_chr(const std::vector<Interval> &intervals,
+                                                                   const ChrSizesVector &chr_sizes);
 };
 
 #endif // MODEL_H
@@ -1,15 +1,28 @@
 #include "WindowModel.hpp"
 #include "../Helpers/Helpers.hpp"
+#include "../DisjointSparseTable/DisjointSparseTable.hpp"
+#include "../Interval/ChrDictionary.hpp"
 #include "../Interval/Section.hpp"
+#include "../ParallelSort/ParallelSort.hpp"
+#include "../Profiler/Profiler.hpp"
 #include "../Results/WindowResult.hpp"
 #include "../SegTree/SegTree.hpp"
+#include "../SlidingWindow/SlidingWindow.hpp"
 #include <algorithm>
-#include <set>
+#include <iterator>
+
+// number of sections or windows of one chromosome that are processed by a single task
+const size_t SECTION_TASK_GRAINSIZE = 16;
+
+// number of windows whose segment tree queries are answered by one batch
+const size_t WINDOW_QUERY_CHUNK = 1 << 12;
 
 WindowModel::WindowModel() {}
 WindowModel::WindowModel(std::vector<Interval> windows, std::vector<Interval> ref_intervals,
-                         std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map, Algorithm algorithm)
-    : windows(windows), ref_intervals(ref_intervals), query_intervals(query_intervals), algorithm(algorithm) {
+                         std::vector<Interval> query_intervals, ChrSizesMap chr_sizes_map, Algorithm algorithm,
+                         long long memory_budget)
+    : windows(std::move(windows)), ref_intervals(std::move(ref_intervals)), query_intervals(std::move(query_intervals)),
+      algorithm(algorithm), memory_budget(memory_budget) {
 
   chr_sizes = chr_sizes_map_to_array(chr_sizes_map);
   std::sort(chr_sizes.begin(), chr_sizes.end());
@@ -48,6 +61,27 @@ std::vector<std::vector<Interval>> WindowModel::get_windows_intervals_naive(cons
   return results;
 }
 
+template <typename WindowType>
+std::vector<std::pair<size_t, size_t>>
+WindowModel::get_windows_interval_ranges(const std::vector<WindowType> &windows,
+                                         const std::vector<Interval> &intervals) {
+  static_assert(std::is_base_of<Interval, WindowType>::value, "WindowType must inherit from Interval");
+
+  // sorted non-overlapping intervals have non-decreasing ends, so both bounds are binary searches
+  std::vector<std::pair<size_t, size_t>> ranges(windows.size());
+  for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++) {
+    long long window_begin = windows[windows_idx].get_begin(), window_end = windows[windows_idx].get_end();
+    auto first = std::partition_point(intervals.begin(), intervals.end(), [window_begin](const Interval &interval) {
+      return interval.end <= window_begin;
+    });
+    auto last = std::partition_point(first, intervals.end(),
+                                     [window_end](const Interval &interval) { return interval.begin < window_end; });
+    ranges[windows_idx] = {first - intervals.begin(), last - intervals.begin()};
+  }
+
+  return ranges;
+}
+
 template <typename WindowType>
 std::vector<std::vector<Interval>> WindowModel::get_windows_intervals(const std::vector<WindowType> &windows,
                                                                       const std::vector<Interval> &intervals) {
@@ -64,133 +98,115 @@ std::vector<std::vector<Interval>> WindowModel::get_windows_intervals(const std:
     exit(1);
   }
 
-  struct Event {
-    long long pos;
-    bool start, interval;
-    size_t idx;
-  };
-
-  std::vector<Event> events((windows.size() << 1) + (intervals.size() << 1));
-
-  for (size_t idx = 0; idx < windows.size(); idx++) {
-    Interval window = windows[idx];
-    events[idx << 1] = {window.get_begin(), 1, 0, idx};
-    events[(idx << 1) | 1] = {window.get_end(), 0, 0, idx};
-  }
-
-  size_t buf = windows.size() << 1;
-  for (size_t idx = 0; idx < intervals.size(); idx++) {
-    Interval interval = intervals[idx];
-    events[buf + (idx << 1)] = {interval.begin, 1, 1, idx};
-    events[buf + (idx << 1) + 1] = {interval.end, 0, 1, idx};
+  std::vector<Interval> sorted_intervals;
+  bool is_sorted = std::is_sorted(intervals.begin(), intervals.end());
+  if (!is_sorted) {
+    sorted_intervals = intervals;
+    sort_intervals(sorted_intervals);
   }
+  const std::vector<Interval> &ordered_intervals = is_sorted ? intervals : sorted_intervals;
 
-  std::sort(events.begin(), events.end(), [](const Event &e1, const Event &e2) {
-    if (e1.pos == e2.pos) {
-      if (e1.start == e2.start) {
-        if (e1.interval == e2.interval) {
-          return e1.idx < e2.idx;
-        }
-        return e1.interval < e2.interval;
-      }
-      return e1.start < e2.start;
-    }
-    return e1.pos < e2.pos;
-  });
-
-  std::set<int> opened_intervals, opened_windows;
-  for (Event event : events) {
-    if (event.start) {
-      if (event.interval) {
-        opened_intervals.insert(event.idx);
-      } else {
-        opened_windows.insert(event.idx);
-      }
-    } else {
-      // ends of windows should come first so that we
-      // do not close the intervals before closing the windows
-      if (!event.interval) {
-        for (int interval_idx : opened_intervals) {
-          Interval sliced_interval = slice_interval_by_window(windows[event.idx], intervals[interval_idx]);
-          if (sliced_interval.length() < 1)
-            continue;
-          results[event.idx].push_back(sliced_interval);
-        }
-        opened_windows.erase(event.idx);
-      } else {
-        // if there are windows opened add this interval to them
-        for (int window_idx : opened_windows) {
-          Interval sliced_interval = slice_interval_by_window(windows[window_idx], intervals[event.idx]);
-          if (sliced_interval.length() < 1)
-            continue;
-          results[window_idx].push_back(sliced_interval);
-        }
-        opened_intervals.erase(event.idx);
-      }
+  std::vector<std::pair<size_t, size_t>> ranges = get_windows_interval_ranges(windows, ordered_intervals);
+  for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++) {
+    for (size_t interval_idx = ranges[windows_idx].first; interval_idx < ranges[windows_idx].second; interval_idx++) {
+      Interval sliced_interval = slice_interval_by_window(windows[windows_idx], ordered_intervals[interval_idx]);
+      if (sliced_interval.length() < 1)
+        continue;
+      results[windows_idx].push_back(sliced_interval);
     }
   }
 
   return results;
 }
 
+std::vector<IntervalsView> WindowModel::get_windows_intervals_views(const std::vector<Interval> &windows,
+                                                                    const std::vector<Interval> &intervals) {
+  auto columns = std::make_shared<const IntervalColumns>(intervals);
+  if (!columns->is_sorted_non_overlapping()) {
+    logger.error("intervals need to be sorted and non-overlapping for splitting into windows to happen.");
+    exit(1);
+  }
+
+  std::vector<std::pair<size_t, size_t>> ranges = get_windows_interval_ranges(windows, intervals);
+  std::vector<IntervalsView> views;
+  views.reserve(windows.size());
+  for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++)
+    views.emplace_back(columns, ranges[windows_idx].first, ranges[windows_idx].second, windows[windows_idx].begin,
+                       windows[windows_idx].end);
+  return views;
+}
+
 std::vector<WindowResult> WindowModel::run() {
   logger.info("Running WindowModel...");
   logger.info("Sorting intervals and windows...");
+  ProfileScope preprocessing_scope(Phase::PREPROCESSING);
 
-  std::sort(ref_intervals.begin(), ref_intervals.end());
-  std::sort(query_intervals.begin(), query_intervals.end());
-  std::sort(windows.begin(), windows.end());
+  // intervals and windows from preprocess_intervals are already sorted
+  for (std::vector<Interval> *intervals : {&ref_intervals, &query_intervals, &windows})
+    if (!std::is_sorted(intervals->begin(), intervals->end()))
+      sort_intervals(*intervals);
 
   logger.info("Grouping intervals and windows by chromosome...");
 
-  std::vector<std::vector<Interval>> windows_by_chr(chr_sizes.size()), ref_intervals_by_chr(chr_sizes.size()),
-      query_intervals_by_chr(chr_sizes.size());
+  std::vector<std::vector<Interval>> windows_by_chr = split_intervals_by_chr(windows, chr_sizes),
+                                     ref_intervals_by_chr = split_intervals_by_chr(ref_intervals, chr_sizes),
+                                     query_intervals_by_chr = split_intervals_by_chr(query_intervals, chr_sizes);
+  preprocessing_scope.stop();
+
+  // every chromosome writes only into its own slot, slots are joined in chromosome order afterwards
+  std::vector<std::vector<WindowResult>> probs_by_window_by_chr(chr_sizes.size());
 
-  for (size_t chr_sizes_idx = 0, windows_idx = 0, ref_idx = 0, query_idx = 0; chr_sizes_idx < chr_sizes.size();
-       chr_sizes_idx++) {
-    std::string chr_name = chr_sizes[chr_sizes_idx].first;
+  // largest chromosomes are started first, their sections are split into further tasks which idle threads steal
+  std::vector<size_t> chr_order(chr_sizes.size());
+  for (size_t chr_sizes_idx = 0; chr_sizes_idx < chr_sizes.size(); chr_sizes_idx++)
+    chr_order[chr_sizes_idx] = chr_sizes_idx;
+  std::stable_sort(chr_order.begin(), chr_order.end(),
+                   [this](size_t a, size_t b) { return chr_sizes[a].second > chr_sizes[b].second; });
 
-    windows_by_chr[chr_sizes_idx] = select_intervals_by_chr_name(windows, windows_idx, chr_name);
-    ref_intervals_by_chr[chr_sizes_idx] = select_intervals_by_chr_name(ref_intervals, ref_idx, chr_name),
-    query_intervals_by_chr[chr_sizes_idx] = select_intervals_by_chr_name(query_intervals, query_idx, chr_name);
+// turn off for debugging
+#pragma omp parallel
+#pragma omp single
+  for (size_t chr_sizes_idx : chr_order) {
+#pragma omp task
+    probs_by_window_by_chr[chr_sizes_idx] =
+        probs_by_window_single_chr(windows_by_chr[chr_sizes_idx], ref_intervals_by_chr[chr_sizes_idx],
+                                   query_intervals_by_chr[chr_sizes_idx], chr_sizes[chr_sizes_idx]);
   }
 
+  size_t windows_count = 0;
+  for (const std::vector<WindowResult> &chromosome_probs_by_window : probs_by_window_by_chr)
+    windows_count += chromosome_probs_by_window.size();
+
   std::vector<WindowResult> probs_by_window;
+  probs_by_window.reserve(windows_count);
+  for (std::vector<WindowResult> &chromosome_probs_by_window : probs_by_window_by_chr)
+    std::move(chromosome_probs_by_window.begin(), chromosome_probs_by_window.end(),
+              std::back_inserter(probs_by_window));
 
-// turn off for debugging
-#pragma omp parallel for
-  for (size_t chr_sizes_idx = 0; chr_sizes_idx < chr_sizes.size(); chr_sizes_idx++) {
-    std::vector<WindowResult> chromosome_probs_by_window;
-    if (algorithm == Algorithm::NAIVE) {
-      chromosome_probs_by_window =
-          probs_by_window_single_chr_naive(windows_by_chr[chr_sizes_idx], ref_intervals_by_chr[chr_sizes_idx],
-                                           query_intervals_by_chr[chr_sizes_idx], chr_sizes[chr_sizes_idx]);
-    } else if (algorithm == Algorithm::SLOW_BAD) {
-      chromosome_probs_by_window =
-          probs_by_window_single_chr_smarter(windows_by_chr[chr_sizes_idx], ref_intervals_by_chr[chr_sizes_idx],
-                                             query_intervals_by_chr[chr_sizes_idx], chr_sizes[chr_sizes_idx], false);
-    } else if (algorithm == Algorithm::SLOW) {
-      chromosome_probs_by_window = probs_by_window_single_chr_smarter_new(
-          windows_by_chr[chr_sizes_idx], ref_intervals_by_chr[chr_sizes_idx], query_intervals_by_chr[chr_sizes_idx],
-          chr_sizes[chr_sizes_idx], false);
-    } else if (algorithm == Algorithm::FAST_BAD) {
-      chromosome_probs_by_window =
-          probs_by_window_single_chr_smarter(windows_by_chr[chr_sizes_idx], ref_intervals_by_chr[chr_sizes_idx],
-                                             query_intervals_by_chr[chr_sizes_idx], chr_sizes[chr_sizes_idx], true);
-    } else if (algorithm == Algorithm::FAST) {
-      chromosome_probs_by_window =
-          probs_by_window_single_chr_smarter_new(windows_by_chr[chr_sizes_idx], ref_intervals_by_chr[chr_sizes_idx],
-                                                 query_intervals_by_chr[chr_sizes_idx], chr_sizes[chr_sizes_idx], true);
-    } else {
-      logger.error("invalid algorithm.");
-      exit(1);
-    }
+  return probs_by_window;
+}
 
-    probs_by_window.reserve(probs_by_window.size() + chromosome_probs_by_window.size());
-    probs_by_window.insert(probs_by_window.end(), chromosome_probs_by_window.begin(), chromosome_probs_by_window.end());
+std::vector<WindowResult> WindowModel::probs_by_window_single_chr(
+    const std::vector<Interval> &windows, const std::vector<Interval> &ref_intervals,
+    const std::vector<Interval> &query_intervals, const std::pair<std::string, long long> chr_size_entry) {
+  if (algorithm == Algorithm::NAIVE) {
+    return probs_by_window_single_chr_naive(windows, ref_intervals, query_intervals, chr_size_entry);
+  } else if (algorithm == Algorithm::SLOW_BAD) {
+    return probs_by_window_single_chr_smarter(windows, ref_intervals, query_intervals, chr_size_entry, false);
+  } else if (algorithm == Algorithm::SLOW) {
+    return probs_by_window_single_chr_smarter_new(windows, ref_intervals, query_intervals, chr_size_entry, false);
+  } else if (algorithm == Algorithm::FAST_BAD) {
+    return probs_by_window_single_chr_smarter(windows, ref_intervals, query_intervals, chr_size_entry, true);
+  } else if (algorithm == Algorithm::FAST) {
+    return probs_by_window_single_chr_smarter_new(windows, ref_intervals, query_intervals, chr_size_entry, true);
+  } else if (algorithm == Algorithm::SLIDING) {
+    return probs_by_window_single_chr_sliding(windows, ref_intervals, query_intervals, chr_size_entry);
+  } else if (algorithm == Algorithm::SPARSE) {
+    return probs_by_window_single_chr_sparse(windows, ref_intervals, query_intervals, chr_size_entry);
   }
 
-  return probs_by_window;
+  logger.error("invalid algorithm.");
+  exit(1);
 }
 
 std::vector<WindowResult> WindowModel::probs_by_window_single_chr_naive(
@@ -200,22 +216,29 @@ std::vector<WindowResult> WindowModel::probs_by_window_single_chr_naive(
   logger.info("Loading windows and their intervals for chromosome: " + chr_name);
 
   long long chr_size = chr_size_entry.second;
+  uint32_t chr_id = ChrDictionary::get_id(chr_name);
 
-  std::vector<std::vector<Interval>> ref_intervals_by_window = get_windows_intervals<Interval>(windows, ref_intervals);
-  std::vector<std::vector<Interval>> query_intervals_by_window =
-      get_windows_intervals<Interval>(windows, query_intervals);
+  ProfileScope splitting_scope(Phase::SECTION_SPLITTING, chr_id);
+  std::vector<IntervalsView> ref_intervals_by_window = get_windows_intervals_views(windows, ref_intervals),
+                             query_intervals_by_window = get_windows_intervals_views(windows, query_intervals);
+  splitting_scope.stop();
 
   logger.info("Calculating probs for windows in chromsome: " + chr_name);
 
   std::vector<WindowResult> probs_by_window;
 
+  ProfileScope markov_chain_scope(Phase::MARKOV_CHAIN, chr_id);
   MarkovChain markov_chain(chr_size, query_intervals);
+  markov_chain_scope.stop();
 
+  // every window runs its own DP
+  ProfileScope queries_scope(Phase::WINDOW_QUERIES, chr_id);
   for (size_t window_idx = 0; window_idx < windows.size(); window_idx++) {
     long long overlap_count =
-        count_overlaps_single_chr(ref_intervals_by_window[window_idx], query_intervals_by_window[window_idx]);
-    std::vector<long double> probs = eval_probs_single_chr_direct(
-        ref_intervals_by_window[window_idx], query_intervals_by_window[window_idx], markov_chain, chr_size);
+        IntervalsView::count_overlaps(ref_intervals_by_window[window_idx], query_intervals_by_window[window_idx]);
+    // only the reference intervals of the current window are copied, the DP itself doesn't read the query
+    std::vector<long double> probs = eval_probs_single_chr_direct(ref_intervals_by_window[window_idx].to_vector(), {},
+                                                                  markov_chain, chr_size);
     Interval cur_window = windows[window_idx];
     probs_by_window.push_back(WindowResult(cur_window, overlap_count, probs));
   }
@@ -231,8 +254,10 @@ std::vector<WindowResult> WindowModel::probs_by_window_single_chr_smarter(
     return {};
   }
   long long chr_size = chr_size_entry.second;
+  uint32_t chr_id = windows.front().chr_id;
 
   // 1. create sections from (possibly) overlapping set of windows
+  ProfileScope splitting_scope(Phase::SECTION_SPLITTING, chr_id);
   WindowSectionSplitResult windowSectionSplitResult =
       split_windows_into_non_overlapping_sections(windows, ref_intervals, query_intervals);
   std::vector<Section> sections = windowSectionSplitResult.get_sections();
@@ -240,31 +265,37 @@ std::vector<WindowResult> WindowModel::probs_by_window_single_chr_smarter(
 
   // 2. load intervals into sections, will be fast since both are
   // non-overlapping
-  std::vector<std::vector<Interval>> ref_intervals_by_section = get_windows_intervals<Section>(sections, ref_intervals),
-                                     query_intervals_by_section =
-                                         get_windows_intervals<Section>(sections, query_intervals);
+  load_sections_intervals(sections, ref_intervals, query_intervals);
+  splitting_scope.stop();
   // 3. calculate transition matrices
+  ProfileScope markov_chain_scope(Phase::MARKOV_CHAIN, chr_id);
   MarkovChain markov_chain(chr_size, query_intervals);
+  markov_chain_scope.stop();
   // markov_chain.print();
 
   // 4. calculature probs and overlap of each section
+  ProfileScope dp_scope(Phase::SECTION_DP, chr_id);
   for (size_t sections_idx = 0; sections_idx < sections.size(); sections_idx++) {
-    sections[sections_idx].set_ref_intervals(ref_intervals_by_section[sections_idx]);
-    sections[sections_idx].set_query_intervals(query_intervals_by_section[sections_idx]);
     SectionProbs probs = eval_probs_single_section(sections[sections_idx], markov_chain);
     sections[sections_idx].set_probs(probs);
-    long long current_overlap_count = count_overlaps_single_chr(sections[sections_idx].get_ref_intervals(),
-                                                                sections[sections_idx].get_query_intervals());
+    const Section &section = sections[sections_idx];
+    long long current_overlap_count =
+        IntervalsView::count_overlaps(section.get_ref_intervals(), section.get_query_intervals());
     sections[sections_idx].set_overlap_count(current_overlap_count);
   }
 
+  dp_scope.stop();
+
   // 4.1 make a segment tree on top of the sections if should
+  ProfileScope build_scope(Phase::SEGTREE_BUILD, chr_id);
   SegTree<Section> st =
       use_segtree ? SegTree<Section>(join_sections_segtree, Section(), sections, markov_chain) : SegTree<Section>();
+  build_scope.stop();
 
   // 5. merge section probs for each window
   std::vector<WindowResult> probs_by_window(windows.size());
 
+  ProfileScope queries_scope(Phase::WINDOW_QUERIES, chr_id);
   for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++) {
     Interval span = spans[windows_idx];
     Section section;
@@ -291,8 +322,26 @@ std::vector<WindowResult> WindowModel::probs_by_window_single_chr_smarter(
   return probs_by_window;
 }
 
+// sections only keep views into one copy of the chromosome intervals
+void WindowModel::load_sections_intervals(std::vector<Section> &sections, const std::vector<Interval> &ref_intervals,
+                                          const std::vector<Interval> &query_intervals) {
+  std::vector<std::pair<long long, long long>> ranges;
+  for (const Section &section : sections)
+    ranges.push_back({section.get_begin(), section.get_end()});
+
+  std::vector<IntervalsView> ref_views = IntervalsView::split_by_ranges(
+                                 std::make_shared<const IntervalColumns>(ref_intervals), ranges),
+                             query_views = IntervalsView::split_by_ranges(
+                                 std::make_shared<const IntervalColumns>(query_intervals), ranges);
+
+  for (size_t sections_idx = 0; sections_idx < sections.size(); sections_idx++) {
+    sections[sections_idx].set_ref_intervals(ref_views[sections_idx]);
+    sections[sections_idx].set_query_intervals(query_views[sections_idx]);
+  }
+}
+
 SectionProbs WindowModel::eval_probs_single_section(const Section &section, const MarkovChain &markov_chain) {
-  const std::vector<Interval> &ref_intervals = section.get_ref_intervals();
+  const std::vector<Interval> ref_intervals = section.get_ref_intervals().to_vector();
   MultiProbs probs_normal =
       eval_probs_single_chr_direct_new(ref_intervals, section.get_begin(), section.get_end(), markov_chain);
 
@@ -331,6 +380,14 @@ template std::vector<std::vector<Interval>>
 WindowModel::get_windows_intervals<Section>(const std::vector<Section> &sections,
                                             const std::vector<Interval> &intervals);
 
+template std::vector<std::pair<size_t, size_t>>
+WindowModel::get_windows_interval_ranges<Interval>(const std::vector<Interval> &windows,
+                                                   const std::vector<Interval> &intervals);
+
+template std::vector<std::pair<size_t, size_t>>
+WindowModel::get_windows_interval_ranges<Section>(const std::vector<Section> &sections,
+                                                  const std::vector<Interval> &intervals);
+
 std::vector<WindowResult> WindowModel::probs_by_window_single_chr_smarter_new(
     const std::vector<Interval> &windows, const std::vector<Interval> &ref_intervals,
     const std::vector<Interval> &query_intervals, const std::pair<std::string, long long> chr_size_entry,
@@ -340,57 +397,223 @@ std::vector<WindowResult> WindowModel::probs_by_window_single_chr_smarter_new(
   }
 
   long long chr_size = chr_size_entry.second;
+  uint32_t chr_id = windows.front().chr_id;
 
   // 1. create sections from (possibly) overlapping set of windows
+  ProfileScope splitting_scope(Phase::SECTION_SPLITTING, chr_id);
   WindowSectionSplitResult windowSectionSplitResult =
       split_windows_into_non_overlapping_sections(windows, ref_intervals, query_intervals);
   std::vector<Section> sections = windowSectionSplitResult.get_sections();
   std::vector<Interval> spans = windowSectionSplitResult.get_spans();
+  splitting_scope.stop();
 
-  // 2. load intervals into sections, will be fast since both are
-  // non-overlapping
-  std::vector<std::vector<Interval>> ref_intervals_by_section = get_windows_intervals<Section>(sections, ref_intervals),
-                                     query_intervals_by_section =
-                                         get_windows_intervals<Section>(sections, query_intervals);
-  // 3. calculate transition matrices
+  // 2. calculate transition matrices
+  ProfileScope markov_chain_scope(Phase::MARKOV_CHAIN, chr_id);
   MarkovChain markov_chain(chr_size, query_intervals);
-  // markov_chain.print();
+  markov_chain_scope.stop();
 
-  // 4. calculature probs and overlap of each section
-  for (size_t sections_idx = 0; sections_idx < sections.size(); sections_idx++) {
-    sections[sections_idx].set_ref_intervals(ref_intervals_by_section[sections_idx]);
-    sections[sections_idx].set_query_intervals(query_intervals_by_section[sections_idx]);
+  // 3. and 4. load intervals into sections and calculate probs and overlap of each section
+  eval_sections_new(sections, ref_intervals, query_intervals, markov_chain);
+
+  // 4.1 make a segment tree on top of the sections if should
+  ProfileScope build_scope(Phase::SEGTREE_BUILD, chr_id);
+  SegTree<Section> st =
+      use_segtree ? SegTree<Section>(join_sections_new_segtree, Section(), sections, markov_chain) : SegTree<Section>();
+  build_scope.stop();
+
+  // 5. merge section probs for each window, windows are processed in chunks to bound the memory of batched queries
+  std::vector<WindowResult> probs_by_window(windows.size());
+
+  for (size_t chunk_begin = 0; chunk_begin < windows.size(); chunk_begin += WINDOW_QUERY_CHUNK) {
+    size_t chunk_end = std::min(windows.size(), chunk_begin + WINDOW_QUERY_CHUNK);
+
+    std::vector<Section> chunk_sections;
+    if (use_segtree) {
+      ProfileScope batch_scope(Phase::WINDOW_QUERIES, chr_id);
+      std::vector<std::pair<int, int>> ranges;
+      for (size_t windows_idx = chunk_begin; windows_idx < chunk_end; windows_idx++)
+        ranges.push_back({spans[windows_idx].begin, spans[windows_idx].end});
+      chunk_sections = st.query_batch(ranges);
+    }
+
+#pragma omp taskloop default(shared) grainsize(SECTION_TASK_GRAINSIZE)
+    for (size_t windows_idx = chunk_begin; windows_idx < chunk_end; windows_idx++) {
+      ProfileScope queries_scope(Phase::WINDOW_QUERIES, chr_id);
+      Interval span = spans[windows_idx];
+      Section section;
+
+      if (!use_segtree) {
+        section = sections[span.begin];
 
+        // merge probs for sections
+        for (long long sections_idx = span.begin + 1; sections_idx < span.end; sections_idx++) {
+          Section next_section = sections[sections_idx];
+          section = join_sections_new(section, next_section, markov_chain);
+        }
+      } else {
+        section = std::move(chunk_sections[windows_idx - chunk_begin]);
+      }
+
+      correct_ends(section, markov_chain);
+
+      // merge the final 4 sets of probs for window into one
+      std::vector<long double> cur_windows_single_probs =
+          merge_multi_probs(section.get_probs().get_except_first_and_last(), markov_chain);
+      probs_by_window[windows_idx] =
+          WindowResult(windows[windows_idx], section.get_overlap_count(), cur_windows_single_probs);
+    }
+  }
+
+  return probs_by_window;
+}
+
+void WindowModel::eval_sections_new(std::vector<Section> &sections, const std::vector<Interval> &ref_intervals,
+                                    const std::vector<Interval> &query_intervals, const MarkovChain &markov_chain) {
+  uint32_t chr_id = sections.empty() ? Profiler::NO_CHROMOSOME : sections.front().chr_id;
+
+  // load intervals into sections, will be fast since both are non-overlapping
+  ProfileScope splitting_scope(Phase::SECTION_SPLITTING, chr_id);
+  load_sections_intervals(sections, ref_intervals, query_intervals);
+  splitting_scope.stop();
+
+  // sections are independent so they run as tasks
+#pragma omp taskloop default(shared) grainsize(SECTION_TASK_GRAINSIZE)
+  for (size_t sections_idx = 0; sections_idx < sections.size(); sections_idx++) {
+    ProfileScope dp_scope(Phase::SECTION_DP, chr_id);
     SectionProbs probs = eval_probs_single_section_new(sections[sections_idx], markov_chain);
     sections[sections_idx].set_probs(probs);
 
-    long long current_overlap_count = count_overlaps_single_chr(sections[sections_idx].get_ref_intervals(),
-                                                                sections[sections_idx].get_query_intervals());
+    const Section &section = sections[sections_idx];
+    long long current_overlap_count =
+        IntervalsView::count_overlaps(section.get_ref_intervals(), section.get_query_intervals());
     sections[sections_idx].set_overlap_count(current_overlap_count);
   }
+}
 
-  // 4.1 make a segment tree on top of the sections if should
-  SegTree<Section> st =
-      use_segtree ? SegTree<Section>(join_sections_new_segtree, Section(), sections, markov_chain) : SegTree<Section>();
+std::vector<WindowResult> WindowModel::probs_by_window_single_chr_sliding(
+    const std::vector<Interval> &windows, const std::vector<Interval> &ref_intervals,
+    const std::vector<Interval> &query_intervals, const std::pair<std::string, long long> chr_size_entry) {
+  if (windows.empty()) {
+    return {};
+  }
 
-  // 5. merge section probs for each window
+  long long chr_size = chr_size_entry.second;
+  uint32_t chr_id = windows.front().chr_id;
+
+  ProfileScope splitting_scope(Phase::SECTION_SPLITTING, chr_id);
+  WindowSectionSplitResult windowSectionSplitResult =
+      split_windows_into_non_overlapping_sections(windows, ref_intervals, query_intervals);
+  std::vector<Section> sections = windowSectionSplitResult.get_sections();
+  std::vector<Interval> spans = windowSectionSplitResult.get_spans();
+  splitting_scope.stop();
+
+  ProfileScope markov_chain_scope(Phase::MARKOV_CHAIN, chr_id);
+  MarkovChain markov_chain(chr_size, query_intervals);
+  markov_chain_scope.stop();
+  eval_sections_new(sections, ref_intervals, query_intervals, markov_chain);
+
+  // windows are sorted, so for dense windows both ends of the spans only move forward and every section is pushed
+  // and popped once. each chunk of windows starts with its own empty queue so the chunks can run in parallel
   std::vector<WindowResult> probs_by_window(windows.size());
+  size_t chunks_count = (windows.size() + WINDOW_QUERY_CHUNK - 1) / WINDOW_QUERY_CHUNK;
 
-  for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++) {
-    Interval span = spans[windows_idx];
-    Section section;
+#pragma omp taskloop default(shared)
+  for (size_t chunk_idx = 0; chunk_idx < chunks_count; chunk_idx++) {
+    ProfileScope queries_scope(Phase::WINDOW_QUERIES, chr_id);
+    size_t chunk_begin = chunk_idx * WINDOW_QUERY_CHUNK,
+           chunk_end = std::min(windows.size(), chunk_begin + WINDOW_QUERY_CHUNK);
 
-    if (!use_segtree) {
-      section = sections[span.begin];
+    SlidingWindow<Section> sliding_window(join_sections_new_segtree, Section(), markov_chain);
+    long long queue_begin = 0, queue_end = 0;
 
-      // merge probs for sections
-      for (long long sections_idx = span.begin + 1; sections_idx < span.end; sections_idx++) {
-        Section next_section = sections[sections_idx];
-        section = join_sections_new(section, next_section, markov_chain);
+    for (size_t windows_idx = chunk_begin; windows_idx < chunk_end; windows_idx++) {
+      Interval span = spans[windows_idx];
+
+      // windows that aren't monotone (e.g. nested ones) or don't overlap the previous one start a new queue
+      if (span.begin < queue_begin || span.end < queue_end || span.begin >= queue_end) {
+        sliding_window.clear();
+        queue_begin = queue_end = span.begin;
       }
-    } else {
-      section = st.query(span.begin, span.end);
+      for (; queue_end < span.end; queue_end++)
+        sliding_window.push(sections[queue_end]);
+      for (; queue_begin < span.begin; queue_begin++)
+        sliding_window.pop();
+
+      Section section = sliding_window.query();
+      correct_ends(section, markov_chain);
+
+      // merge the final 4 sets of probs for window into one
+      std::vector<long double> cur_windows_single_probs =
+          merge_multi_probs(section.get_probs().get_except_first_and_last(), markov_chain);
+      probs_by_window[windows_idx] =
+          WindowResult(windows[windows_idx], section.get_overlap_count(), cur_windows_single_probs);
     }
+  }
+
+  return probs_by_window;
+}
+
+std::vector<WindowResult> WindowModel::probs_by_window_single_chr_sparse(
+    const std::vector<Interval> &windows, const std::vector<Interval> &ref_intervals,
+    const std::vector<Interval> &query_intervals, const std::pair<std::string, long long> chr_size_entry) {
+  if (windows.empty()) {
+    return {};
+  }
+
+  std::string chr_name = chr_size_entry.first;
+  long long chr_size = chr_size_entry.second;
+  uint32_t chr_id = windows.front().chr_id;
+
+  ProfileScope splitting_scope(Phase::SECTION_SPLITTING, chr_id);
+  WindowSectionSplitResult windowSectionSplitResult =
+      split_windows_into_non_overlapping_sections(windows, ref_intervals, query_intervals);
+  std::vector<Section> sections = windowSectionSplitResult.get_sections();
+  std::vector<Interval> spans = windowSectionSplitResult.get_spans();
+  splitting_scope.stop();
+
+  ProfileScope markov_chain_scope(Phase::MARKOV_CHAIN, chr_id);
+  MarkovChain markov_chain(chr_size, query_intervals);
+  markov_chain_scope.stop();
+  eval_sections_new(sections, ref_intervals, query_intervals, markov_chain);
+
+  // only entries as long as the longest window are ever queried
+  int max_span = 1;
+  for (const Interval &span : spans)
+    max_span = std::max(max_span, (int)(span.end - span.begin));
+
+  // the intervals of a joined section are views into the shared columns, so it only owns its four shared MultiProbs
+  // (each with its control block) and, in the one that is filled, one prob per reference interval in each of the 2x2
+  // start and end state combinations
+  std::vector<long long> ref_counts(sections.size() + 1);
+  for (size_t sections_idx = 0; sections_idx < sections.size(); sections_idx++)
+    ref_counts[sections_idx + 1] = ref_counts[sections_idx] + sections[sections_idx].get_ref_intervals().size();
+  const long double joined_section_bytes = sizeof(Section) + 4 * (sizeof(MultiProbs) + 2 * sizeof(void *));
+  long double table_bytes = DisjointSparseTable<Section>::estimate_size(sections.size(), [&](int a, int b) {
+    long long refs = ref_counts[b] - ref_counts[a];
+    return joined_section_bytes + 4 * (refs + 1) * sizeof(long double);
+  }, max_span);
+
+  bool use_table = table_bytes <= (long double)memory_budget * (1 << 20);
+  if (!use_table)
+    logger.warn("Sparse table for chromosome " + chr_name + " would take about " +
+                std::to_string((long long)(table_bytes / (1 << 20))) +
+                " MB, which is over --memory.budget, using a segment tree instead.");
+
+  ProfileScope build_scope(Phase::SEGTREE_BUILD, chr_id);
+  DisjointSparseTable<Section> table =
+      use_table ? DisjointSparseTable<Section>(join_sections_new_segtree, Section(), sections, markov_chain, max_span)
+                : DisjointSparseTable<Section>();
+  SegTree<Section> st =
+      use_table ? SegTree<Section>() : SegTree<Section>(join_sections_new_segtree, Section(), sections, markov_chain);
+  build_scope.stop();
+
+  std::vector<WindowResult> probs_by_window(windows.size());
+
+#pragma omp taskloop default(shared) grainsize(SECTION_TASK_GRAINSIZE)
+  for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++) {
+    ProfileScope queries_scope(Phase::WINDOW_QUERIES, chr_id);
+    Interval span = spans[windows_idx];
+    Section section = use_table ? table.query(span.begin, span.end) : st.query(span.begin, span.end);
 
     correct_ends(section, markov_chain);
 
@@ -405,7 +628,7 @@ std::vector<WindowResult> WindowModel::probs_by_window_single_chr_smarter_new(
 }
 
 SectionProbs WindowModel::eval_probs_single_section_new(const Section &section, const MarkovChain &markov_chain) {
-  std::vector<Interval> ref_intervals = section.get_ref_intervals();
+  std::vector<Interval> ref_intervals = section.get_ref_intervals().to_vector();
 
   long long new_section_start = section.get_begin();
   if (section.get_first_ref_interval_intersected() && !ref_intervals.empty()) {
@@ -428,7 +651,7 @@ SectionProbs WindowModel::eval_probs_single_section_new(const Section &section,
 }
 
 void WindowModel::correct_ends(Section &section, const MarkovChain &markov_chain) {
-  std::vector<Interval> ref_intervals = section.get_ref_intervals();
+  const IntervalsView &ref_intervals = section.get_ref_intervals();
   MultiProbs new_probs = section.get_probs().get_except_first_and_last();
 
   // print_multiprobs(new_probs);
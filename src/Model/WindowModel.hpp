@@ -4,9 +4,11 @@
 #include "../Enums/Enums.hpp"
 #include "../Helpers/Helpers.hpp"
 #include "../Interval/Interval.hpp"
+#include "../Interval/IntervalsView.hpp"
 #include "../Results/SectionProbs.hpp"
 #include "../Results/WindowResult.hpp"
 #include "Model.hpp"
+#include <utility>
 #include <vector>
 
 class WindowModel : Model {
@@ -15,16 +17,28 @@ public:
   ChrSizesVector chr_sizes;
   std::string method;
   Algorithm algorithm;
+  // in megabytes, see probs_by_window_single_chr_sparse
+  long long memory_budget = 4096;
 
   WindowModel();
   WindowModel(std::vector<Interval> windows, std::vector<Interval> ref_intervals, std::vector<Interval> query_intervals,
-              ChrSizesMap chr_sizes_map, Algorithm algorithm);
+              ChrSizesMap chr_sizes_map, Algorithm algorithm, long long memory_budget = 4096);
 
   std::vector<WindowResult> run();
 
   static std::vector<std::vector<Interval>> get_windows_intervals_naive(const std::vector<Interval> &windows,
                                                                         const std::vector<Interval> &intervals);
 
+  // [first, last) indices of the sorted non-overlapping `intervals` that overlap each window
+  template <typename WindowType>
+  static std::vector<std::pair<size_t, size_t>> get_windows_interval_ranges(const std::vector<WindowType> &windows,
+                                                                            const std::vector<Interval> &intervals);
+
+  // views of the sorted non-overlapping `intervals` clipped to every window, all of them over one shared copy of the
+  // intervals, so overlapping windows don't copy the intervals they have in common
+  static std::vector<IntervalsView> get_windows_intervals_views(const std::vector<Interval> &windows,
+                                                                const std::vector<Interval> &intervals);
+
   template <typename WindowType>
   static std::vector<std::vector<Interval>> get_windows_intervals(const std::vector<WindowType> &windows,
                                                                   const std::vector<Interval> &intervals);
@@ -45,12 +59,38 @@ public:
       const std::vector<Interval> &query_intervals, const std::pair<std::string, long long> chr_size_entry,
       bool use_segtree = true);
 
+  // same sections as probs_by_window_single_chr_smarter_new, but windows are answered by sliding a queue over them
+  std::vector<WindowResult> probs_by_window_single_chr_sliding(const std::vector<Interval> &windows,
+                                                               const std::vector<Interval> &ref_intervals,
+                                                               const std::vector<Interval> &query_intervals,
+                                                               const std::pair<std::string, long long> chr_size_entry);
+
+  // same sections as probs_by_window_single_chr_smarter_new, but windows are answered with a single join from a
+  // disjoint sparse table, if the table would take more than `memory_budget` a segment tree is used instead
+  std::vector<WindowResult> probs_by_window_single_chr_sparse(const std::vector<Interval> &windows,
+                                                              const std::vector<Interval> &ref_intervals,
+                                                              const std::vector<Interval> &query_intervals,
+                                                              const std::pair<std::string, long long> chr_size_entry);
+
+  // loads the intervals of every section and evaluates its probs and overlap count
+  void eval_sections_new(std::vector<Section> &sections, const std::vector<Interval> &ref_intervals,
+                         const std::vector<Interval> &query_intervals, const MarkovChain &markov_chain);
+
 private:
+  // dispatches to the per chromosome method selected by `algorithm`
+  std::vector<WindowResult> probs_by_window_single_chr(const std::vector<Interval> &windows,
+                                                       const std::vector<Interval> &windows_ref_intervals,
+                                                       const std::vector<Interval> &windows_query_intervals,
+                                                       const std::pair<std::string, long long> chr_size_entry);
+
   SectionProbs eval_probs_single_section(const Section &section, const MarkovChain &markov_chain);
 
   SectionProbs eval_probs_single_section_new(const Section &section, const MarkovChain &markov_chain);
 
   void correct_ends(Section &section, const MarkovChain &markov_chain);
+
+  static void load_sections_intervals(std::vector<Section> &sections, const std::vector<Interval> &ref_intervals,
+                                      const std::vector<Interval> &query_intervals);
 };
 
 #endif // WINDOWMODEL_H
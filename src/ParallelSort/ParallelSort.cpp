@@ -0,0 +1,18 @@
+#include "ParallelSort.hpp"
+
+void sort_intervals(std::vector<Interval> &intervals) {
+  radix_sort(intervals, [](const Interval &interval) {
+    return ((unsigned __int128)interval.chr_id << 64) | position_key(interval.begin);
+  });
+
+  // intervals with the same begin are rare, sorting their runs by end is cheaper than radix passes over the ends
+  for (size_t idx = 0; idx < intervals.size();) {
+    size_t run_end = idx + 1;
+    while (run_end < intervals.size() && intervals[run_end].chr_id == intervals[idx].chr_id &&
+           intervals[run_end].begin == intervals[idx].begin)
+      run_end++;
+    if (run_end - idx > 1)
+      std::sort(intervals.begin() + idx, intervals.begin() + run_end);
+    idx = run_end;
+  }
+}
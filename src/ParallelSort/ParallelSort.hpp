@@ -0,0 +1,101 @@
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include "../Interval/Interval.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <omp.h>
+#include <utility>
+#include <vector>
+
+// below this size a comparison sort is faster than the passes of the radix sort
+const size_t RADIX_SORT_CUTOFF = 1 << 12;
+
+// unsigned key with the same order as the signed position
+inline uint64_t position_key(long long pos) { return (uint64_t)pos ^ (1ULL << 63); }
+
+// stable LSD radix sort of `values` by `key(value)`, an unsigned integer of up to 128 bits.
+// every pass sorts by one byte of the key, bytes that are equal in all keys are skipped, so keys packed from small
+// positions or few chromosomes take only a few passes. each thread counts and scatters its own contiguous block
+template <typename T, typename KeyFunction> void radix_sort(std::vector<T> &values, KeyFunction key) {
+  using Key = decltype(key(values[0]));
+  size_t n = values.size();
+  if (n < RADIX_SORT_CUTOFF) {
+    std::stable_sort(values.begin(), values.end(), [&key](const T &a, const T &b) { return key(a) < key(b); });
+    return;
+  }
+
+  // a byte varies iff it differs between the bitwise and and the bitwise or of all keys
+  std::vector<Key> ands(omp_get_max_threads(), ~Key(0)), ors(omp_get_max_threads(), 0);
+#pragma omp parallel
+  {
+    Key thread_and = ~Key(0), thread_or = 0;
+#pragma omp for
+    for (size_t idx = 0; idx < n; idx++) {
+      Key value_key = key(values[idx]);
+      thread_and &= value_key;
+      thread_or |= value_key;
+    }
+    ands[omp_get_thread_num()] = thread_and;
+    ors[omp_get_thread_num()] = thread_or;
+  }
+  Key all_and = ~Key(0), all_or = 0;
+  for (size_t thread = 0; thread < ands.size(); thread++) {
+    all_and &= ands[thread];
+    all_or |= ors[thread];
+  }
+
+  std::vector<int> varying_bytes;
+  for (int byte = 0; byte < (int)sizeof(Key); byte++)
+    if (((all_and ^ all_or) >> (8 * byte)) & 0xFF)
+      varying_bytes.push_back(byte);
+  if (varying_bytes.empty())
+    return;
+
+  std::vector<T> buffer(n);
+  std::vector<std::array<size_t, 256>> offsets(omp_get_max_threads());
+#pragma omp parallel
+  {
+    size_t threads = omp_get_num_threads(), thread = omp_get_thread_num();
+    size_t begin = n * thread / threads, end = n * (thread + 1) / threads;
+    std::array<size_t, 256> &thread_offsets = offsets[thread];
+
+    for (size_t pass = 0; pass < varying_bytes.size(); pass++) {
+      const std::vector<T> &from = pass % 2 ? buffer : values;
+      std::vector<T> &to = pass % 2 ? values : buffer;
+      int shift = 8 * varying_bytes[pass];
+
+      thread_offsets.fill(0);
+      for (size_t idx = begin; idx < end; idx++)
+        thread_offsets[(size_t)(key(from[idx]) >> shift) & 0xFF]++;
+#pragma omp barrier
+
+      // elements with a smaller digit go first, within a digit the blocks keep their order
+#pragma omp single
+      {
+        size_t position = 0;
+        for (size_t digit = 0; digit < 256; digit++) {
+          for (size_t block = 0; block < threads; block++) {
+            size_t count = offsets[block][digit];
+            offsets[block][digit] = position;
+            position += count;
+          }
+        }
+      }
+
+      for (size_t idx = begin; idx < end; idx++)
+        to[thread_offsets[(size_t)(key(from[idx]) >> shift) & 0xFF]++] = from[idx];
+#pragma omp barrier
+    }
+  }
+
+  if (varying_bytes.size() % 2)
+    values.swap(buffer);
+}
+
+// sorts intervals by chromosome id, begin and end, the same order as Interval::operator<
+void sort_intervals(std::vector<Interval> &intervals);
+
+#endif // PARALLELSORT_H
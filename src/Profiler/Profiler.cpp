@@ -0,0 +1,171 @@
+#include "Profiler.hpp"
+#include "../Interval/ChrDictionary.hpp"
+#include "../Logger/Logger.hpp"
+
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <vector>
+
+Profiler profiler;
+
+const std::array<std::string, PHASES_COUNT> phase_names = {
+    "loading",        "preprocessing", "markov_chain", "section_splitting", "section_dp", "chromosome_dp",
+    "joint_probs",    "segtree_build", "window_queries", "stats",           "output",     "other"};
+const std::array<std::string, COUNTERS_COUNT> counter_names = {"dp_cells", "matrix_powers", "joins", "bytes_read"};
+
+thread_local Profiler::ThreadProfile *Profiler::current_thread = nullptr;
+
+// innermost running scope of the calling thread
+static thread_local ProfileScope *current_scope = nullptr;
+
+void PhaseStats::add(const PhaseStats &other) {
+  nanoseconds += other.nanoseconds;
+  calls += other.calls;
+  for (size_t counter_idx = 0; counter_idx < COUNTERS_COUNT; counter_idx++)
+    counters[counter_idx] += other.counters[counter_idx];
+}
+
+void Profiler::enable() {
+  enabled_timer.emplace();
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::disable() { enabled.store(false, std::memory_order_relaxed); }
+
+// the thread profiles stay registered, threads keep pointers to them
+void Profiler::reset() {
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  for (ThreadProfile &thread : threads)
+    thread.stats.clear();
+  if (enabled_timer)
+    enabled_timer.emplace();
+}
+
+Profiler::ThreadProfile &Profiler::thread_profile() {
+  if (!current_thread) {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    threads.push_back({threads.size(), {}});
+    current_thread = &threads.back();
+  }
+  return *current_thread;
+}
+
+void Profiler::count_enabled(Counter counter, long long amount) {
+  if (current_scope) {
+    current_scope->counters[(size_t)counter] += amount;
+    return;
+  }
+
+  PhaseStats stats;
+  stats.counters[(size_t)counter] = amount;
+  record(Phase::OTHER, NO_CHROMOSOME, stats);
+}
+
+void Profiler::record(Phase phase, uint32_t chr_id, const PhaseStats &stats) {
+  thread_profile().stats[{phase, chr_id}].add(stats);
+}
+
+void ProfileScope::start(Phase phase, uint32_t chr_id) {
+  running = true;
+  this->phase = phase;
+  parent = current_scope;
+  this->chr_id = chr_id == Profiler::NO_CHROMOSOME && parent ? parent->chr_id : chr_id;
+  current_scope = this;
+  timer.emplace();
+}
+
+ProfileContext ProfileScope::running_context() {
+  if (!current_scope)
+    return {};
+  return {true, current_scope->phase, current_scope->chr_id};
+}
+
+void ProfileScope::finish() {
+  long long nanoseconds = timer->elapsed<std::chrono::nanoseconds>();
+  running = false;
+  current_scope = parent;
+  if (parent)
+    parent->nested_nanoseconds += nanoseconds;
+
+  PhaseStats stats;
+  stats.nanoseconds = nanoseconds - nested_nanoseconds;
+  stats.calls = 1;
+  stats.counters = counters;
+  profiler.record(phase, chr_id, stats);
+}
+
+static std::string json_string(const std::string &value) {
+  std::string escaped = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped + "\"";
+}
+
+static std::string json_stats(const PhaseStats &stats) {
+  std::string json = std::format("\"seconds\": {:.9f}, \"calls\": {}, \"counters\": {{", stats.nanoseconds / 1e9,
+                                 stats.calls);
+  for (size_t counter_idx = 0; counter_idx < COUNTERS_COUNT; counter_idx++)
+    json += std::format("{}{}: {}", counter_idx ? ", " : "", json_string(counter_names[counter_idx]),
+                        stats.counters[counter_idx]);
+  return json + "}";
+}
+
+// phases with their totals, and the same split by thread and by chromosome
+void Profiler::write_report(const std::string &file_path) {
+  double wall_seconds = enabled_timer ? enabled_timer->elapsed<std::chrono::nanoseconds>() / 1e9 : 0;
+
+  std::array<PhaseStats, PHASES_COUNT> totals;
+  std::array<std::map<size_t, PhaseStats>, PHASES_COUNT> by_thread;
+  std::array<std::map<uint32_t, PhaseStats>, PHASES_COUNT> by_chr;
+  {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    for (const ThreadProfile &thread : threads) {
+      for (const auto &[key, stats] : thread.stats) {
+        size_t phase_idx = (size_t)key.first;
+        totals[phase_idx].add(stats);
+        by_thread[phase_idx][thread.thread_idx].add(stats);
+        if (key.second != NO_CHROMOSOME)
+          by_chr[phase_idx][key.second].add(stats);
+      }
+    }
+  }
+
+  std::string json = std::format("{{\n  \"wall_seconds\": {:.9f},\n  \"threads\": {},\n  \"phases\": [", wall_seconds,
+                                 threads.size());
+  bool first_phase = true;
+  for (size_t phase_idx = 0; phase_idx < PHASES_COUNT; phase_idx++) {
+    if (!totals[phase_idx].calls && totals[phase_idx].counters == std::array<long long, COUNTERS_COUNT>{})
+      continue;
+
+    json += std::format("{}\n    {{\"phase\": {}, {},\n     \"by_thread\": [", first_phase ? "" : ",",
+                        json_string(phase_names[phase_idx]), json_stats(totals[phase_idx]));
+    first_phase = false;
+
+    bool first_entry = true;
+    for (const auto &[thread_idx, stats] : by_thread[phase_idx]) {
+      json += std::format("{}\n       {{\"thread\": {}, {}}}", first_entry ? "" : ",", thread_idx, json_stats(stats));
+      first_entry = false;
+    }
+    json += "],\n     \"by_chromosome\": [";
+
+    first_entry = true;
+    for (const auto &[chr_id, stats] : by_chr[phase_idx]) {
+      json += std::format("{}\n       {{\"chr\": {}, {}}}", first_entry ? "" : ",",
+                          json_string(ChrDictionary::get_name(chr_id)), json_stats(stats));
+      first_entry = false;
+    }
+    json += "]}";
+  }
+  json += "\n  ]\n}\n";
+
+  std::ofstream file(file_path, std::ios::trunc);
+  if (!file.is_open()) {
+    logger.error("Failed to open profile file for writing: " + file_path);
+    exit(1);
+  }
+  file << json;
+}
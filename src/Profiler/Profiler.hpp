@@ -0,0 +1,150 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "../Timer/Timer.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+// phases of a run reported by --profile, OTHER collects counters recorded outside of any phase
+enum class Phase {
+  LOADING,
+  PREPROCESSING,
+  MARKOV_CHAIN,
+  SECTION_SPLITTING,
+  SECTION_DP,
+  CHROMOSOME_DP,
+  JOINT_PROBS,
+  SEGTREE_BUILD,
+  WINDOW_QUERIES,
+  STATS,
+  OUTPUT,
+  OTHER,
+  COUNT
+};
+
+enum class Counter { DP_CELLS, MATRIX_POWERS, JOINS, BYTES_READ, COUNT };
+
+const size_t PHASES_COUNT = (size_t)Phase::COUNT, COUNTERS_COUNT = (size_t)Counter::COUNT;
+
+extern const std::array<std::string, PHASES_COUNT> phase_names;
+extern const std::array<std::string, COUNTERS_COUNT> counter_names;
+
+struct PhaseStats {
+  long long nanoseconds = 0;
+  long long calls = 0;
+  std::array<long long, COUNTERS_COUNT> counters{};
+
+  void add(const PhaseStats &other);
+};
+
+class ProfileScope;
+
+// phase and chromosome of the innermost scope of a thread, handed to OpenMP tasks so that their work is reported under
+// the phase that spawned them
+struct ProfileContext {
+  bool active = false;
+  Phase phase = Phase::OTHER;
+  uint32_t chr_id = 0;
+};
+
+// time and counters of every phase, kept per thread and per chromosome, and written as JSON by write_report.
+// while disabled, scopes and counters only test a flag, so the instrumented code runs at full speed
+class Profiler {
+public:
+  // chromosome id of work that does not belong to a chromosome, same as the empty name in ChrDictionary
+  static const uint32_t NO_CHROMOSOME = 0;
+
+  bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+  void enable();
+  void disable();
+  // forgets everything recorded so far, must not be called while any scope is running
+  void reset();
+
+  // adds to the innermost phase running on the calling thread
+  void count(Counter counter, long long amount) {
+    if (is_enabled())
+      count_enabled(counter, amount);
+  }
+
+  void write_report(const std::string &file_path);
+
+private:
+  friend class ProfileScope;
+
+  // stats of one thread by (phase, chromosome id), only that thread writes them until the report is written
+  struct ThreadProfile {
+    size_t thread_idx;
+    std::map<std::pair<Phase, uint32_t>, PhaseStats> stats;
+  };
+
+  // stats of the calling thread once it recorded anything
+  static thread_local ThreadProfile *current_thread;
+
+  std::atomic<bool> enabled = false;
+  std::optional<Timer> enabled_timer;
+  std::mutex threads_mutex;
+  // a deque, so the profiles keep their addresses when other threads register
+  std::deque<ThreadProfile> threads;
+
+  ThreadProfile &thread_profile();
+  void count_enabled(Counter counter, long long amount);
+  void record(Phase phase, uint32_t chr_id, const PhaseStats &stats);
+};
+
+extern Profiler profiler;
+
+// times `phase` from construction until stop() or destruction. time spent in nested scopes on the same thread is
+// reported only for the nested phase. a scope without a chromosome belongs to the chromosome of the enclosing one
+class ProfileScope {
+public:
+  explicit ProfileScope(Phase phase, uint32_t chr_id = Profiler::NO_CHROMOSOME) {
+    if (profiler.is_enabled())
+      start(phase, chr_id);
+  }
+  // continues the phase of `context` on the calling thread, nothing happens if it was taken outside of any scope
+  explicit ProfileScope(const ProfileContext &context) {
+    if (context.active)
+      start(context.phase, context.chr_id);
+  }
+  ~ProfileScope() { stop(); }
+
+  static ProfileContext current_context() {
+    if (!profiler.is_enabled())
+      return {};
+    return running_context();
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+  void stop() {
+    if (running)
+      finish();
+  }
+
+private:
+  friend class Profiler;
+
+  bool running = false;
+  Phase phase;
+  uint32_t chr_id;
+  ProfileScope *parent;
+  // only started when the profiler is enabled, so disabled scopes never read the clock
+  std::optional<Timer> timer;
+  long long nested_nanoseconds = 0;
+  std::array<long long, COUNTERS_COUNT> counters{};
+
+  void start(Phase phase, uint32_t chr_id);
+  void finish();
+  static ProfileContext running_context();
+};
+
+#endif // PROFILER_H
@@ -1,12 +1,18 @@
 #include "SectionProbs.hpp"
 
+static const MultiProbs EMPTY_MULTI_PROBS{};
+
 SectionProbs::SectionProbs() {}
 SectionProbs::SectionProbs(MultiProbs normal, MultiProbs except_first, MultiProbs except_last,
                            MultiProbs except_first_and_last)
-    : normal(normal), except_first(except_first), except_last(except_last),
-      except_first_and_last(except_first_and_last) {}
+    : normal(std::make_shared<const MultiProbs>(std::move(normal))),
+      except_first(std::make_shared<const MultiProbs>(std::move(except_first))),
+      except_last(std::make_shared<const MultiProbs>(std::move(except_last))),
+      except_first_and_last(std::make_shared<const MultiProbs>(std::move(except_first_and_last))) {}
 
-MultiProbs SectionProbs::get_normal() const { return this->normal; }
-MultiProbs SectionProbs::get_except_first() const { return this->except_first; }
-MultiProbs SectionProbs::get_except_last() const { return this->except_last; }
-MultiProbs SectionProbs::get_except_first_and_last() const { return this->except_first_and_last; }
+const MultiProbs &SectionProbs::get_normal() const { return normal ? *normal : EMPTY_MULTI_PROBS; }
+const MultiProbs &SectionProbs::get_except_first() const { return except_first ? *except_first : EMPTY_MULTI_PROBS; }
+const MultiProbs &SectionProbs::get_except_last() const { return except_last ? *except_last : EMPTY_MULTI_PROBS; }
+const MultiProbs &SectionProbs::get_except_first_and_last() const {
+  return except_first_and_last ? *except_first_and_last : EMPTY_MULTI_PROBS;
+}
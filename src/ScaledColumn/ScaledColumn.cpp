@@ -0,0 +1,126 @@
+#include "ScaledColumn.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define SCALED_COLUMN_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define SCALED_COLUMN_TARGETS
+#endif
+
+template <class Real>
+ScaledColumn<Real>::ScaledColumn(int max_count, const std::array<long double, 2> &initial)
+    : max_count(max_count), mantissas0(max_count + 2), mantissas1(max_count + 2), next0(max_count + 2),
+      next1(max_count + 2), ratios(max_count + 2, 1), exponents(max_count + 2) {
+  mantissas0[0] = initial[0];
+  mantissas1[0] = initial[1];
+  renormalize();
+}
+
+// computes counts [0, new_count) of the next column, returns the number of entries that left the normal range.
+// gcc builds the step for AVX2 as well and picks the variant at load time. without FMA the AVX2 variant rounds exactly
+// like the default one, so results do not depend on the machine
+template <class Real>
+SCALED_COLUMN_TARGETS static int step_column(int new_count, const Real *mantissas0, const Real *mantissas1,
+                                             const Real *ratios, Real *next0, Real *next1,
+                                             const TransitionMatrix &dont_hit, const TransitionMatrix &hit) {
+  const Real mantissa_hi = std::ldexp(Real(1), ScaledPrecision<Real>::max_exponent);
+  const Real mantissa_lo = std::ldexp(Real(1), -ScaledPrecision<Real>::max_exponent);
+  const Real d00 = dont_hit[0][0], d01 = dont_hit[0][1], d10 = dont_hit[1][0], d11 = dont_hit[1][1];
+  const Real h00 = hit[0][0], h01 = hit[0][1], h10 = hit[1][0], h11 = hit[1][1];
+
+  next0[0] = mantissas0[0] * d00 + mantissas1[0] * d10;
+  next1[0] = mantissas0[0] * d01 + mantissas1[0] * d11;
+  Real first_largest = std::max(next0[0], next1[0]);
+  int out_of_range = first_largest > mantissa_hi || (first_largest < mantissa_lo && first_largest > 0);
+
+#pragma omp simd reduction(+ : out_of_range)
+  for (int k = 1; k < new_count; k++) {
+    Real hit0 = mantissas0[k - 1] * h00 + mantissas1[k - 1] * h10;
+    Real hit1 = mantissas0[k - 1] * h01 + mantissas1[k - 1] * h11;
+    Real value0 = mantissas0[k] * d00 + mantissas1[k] * d10 + ratios[k] * hit0;
+    Real value1 = mantissas0[k] * d01 + mantissas1[k] * d11 + ratios[k] * hit1;
+    next0[k] = value0;
+    next1[k] = value1;
+    Real largest = std::max(value0, value1);
+    out_of_range += (largest > mantissa_hi) | ((largest < mantissa_lo) & (largest > 0));
+  }
+
+  return out_of_range;
+}
+
+template <class Real> void ScaledColumn<Real>::advance(const TransitionMatrix &dont_hit, const TransitionMatrix &hit) {
+  int new_count = std::min(count + 1, max_count + 1);
+  if (new_count > count) {
+    // the new top count starts at the scale of the one below it
+    exponents[count] = exponents[count - 1];
+    ratios[count] = 1;
+  }
+
+  int out_of_range = step_column(new_count, mantissas0.data(), mantissas1.data(), ratios.data(), next0.data(),
+                                 next1.data(), dont_hit, hit);
+  mantissas0.swap(next0);
+  mantissas1.swap(next1);
+  count = new_count;
+  steps++;
+  mantissas0[count] = mantissas1[count] = 0;
+
+  if (out_of_range)
+    renormalize();
+}
+
+// brings every mantissa into [1/2, 1) and keeps neighbouring exponents at most max_shift apart. a count that would
+// need a larger shift is below 2^-(max_shift + max_exponent) times its neighbour once shifted, such counts are set to
+// zero instead of being renormalized on every step
+template <class Real> void ScaledColumn<Real>::renormalize() {
+  for (int k = 0; k < count; k++) {
+    Real largest = std::max(mantissas0[k], mantissas1[k]);
+    if (largest > 0) {
+      int exponent;
+      std::frexp(largest, &exponent);
+      mantissas0[k] = std::ldexp(mantissas0[k], -exponent);
+      mantissas1[k] = std::ldexp(mantissas1[k], -exponent);
+      exponents[k] += exponent;
+    }
+
+    if (k == 0)
+      continue;
+    long long shift = exponents[k - 1] - exponents[k] - ScaledPrecision<Real>::max_shift;
+    if (largest == 0 || shift >= ScaledPrecision<Real>::max_exponent) {
+      flushed |= largest > 0;
+      mantissas0[k] = mantissas1[k] = 0;
+      exponents[k] = exponents[k - 1];
+    } else if (shift > 0) {
+      mantissas0[k] = std::ldexp(mantissas0[k], -shift);
+      mantissas1[k] = std::ldexp(mantissas1[k], -shift);
+      exponents[k] += shift;
+    }
+  }
+
+  // counts far above their neighbour below get a ratio that underflows to zero, their hits do not matter
+  for (int k = 1; k < count; k++)
+    ratios[k] = std::ldexp(Real(1), (int)std::max(exponents[k - 1] - exponents[k], -32768LL));
+}
+
+template <class Real>
+std::array<long double, 2> ScaledColumn<Real>::unscaled_product(int k, const TransitionMatrix &trailing) const {
+  long double value0 = mantissas0[k], value1 = mantissas1[k];
+  return {value0 * trailing[0][0] + value1 * trailing[1][0], value0 * trailing[0][1] + value1 * trailing[1][1]};
+}
+
+template <class Real>
+std::array<long double, 2> ScaledColumn<Real>::log_state_probs(int k, const TransitionMatrix &trailing) const {
+  std::array<long double, 2> product = unscaled_product(k, trailing);
+  long double log_scale = exponents[k] * std::numbers::ln2_v<long double>;
+  return {std::log(product[0]) + log_scale, std::log(product[1]) + log_scale};
+}
+
+template <class Real> long double ScaledColumn<Real>::log_prob(int k, const TransitionMatrix &trailing) const {
+  std::array<long double, 2> product = unscaled_product(k, trailing);
+  return std::log(product[0] + product[1]) + exponents[k] * std::numbers::ln2_v<long double>;
+}
+
+template class ScaledColumn<double>;
+template class ScaledColumn<long double>;
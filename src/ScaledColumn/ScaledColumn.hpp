@@ -0,0 +1,80 @@
+#ifndef SCALEDCOLUMN_H
+#define SCALEDCOLUMN_H
+
+#include "../Logger/Logger.hpp"
+#include "../MarkovChain/MarkovChain.hpp"
+
+#include <array>
+#include <limits>
+#include <vector>
+
+// a column whose relative error bound exceeds this is recomputed in a wider type (see eval_with_adaptive_precision)
+const long double SCALED_COLUMN_TOLERANCE = 1e-10;
+
+// range and rounding of the floating point type `Real` used for the mantissas of a ScaledColumn
+template <class Real> struct ScaledPrecision {
+  // entries with a larger mantissa, or a smaller nonzero one, are renormalized after the column step
+  static constexpr int max_exponent = std::numeric_limits<Real>::max_exponent / 4;
+  // the exponents of neighbouring entries differ by at most this much, so every step stays far from overflow
+  static constexpr int max_shift = std::numeric_limits<Real>::max_exponent * 3 / 8;
+  static constexpr long double epsilon = std::numeric_limits<Real>::epsilon();
+};
+
+// one column P[j, .] of the overlap DP, entry k is (mantissas0[k], mantissas1[k]) * 2^exponents[k] with mantissas of
+// type `Real`. every overlap count has its own exponent, so far tails do not underflow, while the mantissas of all
+// counts are updated together by a single vectorized loop per column. the column starts as P[0, .] and grows by one
+// count per reference interval up to `max_count`
+template <class Real> class ScaledColumn {
+public:
+  ScaledColumn(int max_count, const std::array<long double, 2> &initial);
+
+  // P[j + 1, k] = P[j, k] * dont_hit + P[j, k - 1] * hit
+  void advance(const TransitionMatrix &dont_hit, const TransitionMatrix &hit);
+
+  int size() const { return count; }
+
+  // log of P[j, k] * trailing for both ending states, and of their sum
+  std::array<long double, 2> log_state_probs(int k, const TransitionMatrix &trailing) const;
+  long double log_prob(int k, const TransitionMatrix &trailing) const;
+
+  // all entries are products and sums of non-negative numbers, each step rounds an entry at most five times relative to
+  // its value (two coefficients, two additions and the ratio), unless a count was flushed to zero by renormalize
+  bool is_precise() const { return !flushed && can_be_precise(steps); }
+
+  // whether a column of this type can stay within the tolerance for `steps` steps at all
+  static bool can_be_precise(long long steps) {
+    return (5 * steps + 2) * ScaledPrecision<Real>::epsilon <= SCALED_COLUMN_TOLERANCE;
+  }
+
+private:
+  int max_count, count = 1;
+  long long steps = 0;
+  bool flushed = false;
+  // index count is always zero, so the step of the new top count reads a zero instead of a missing entry
+  std::vector<Real> mantissas0, mantissas1, next0, next1;
+  // ratios[k] = 2^(exponents[k - 1] - exponents[k]), the factor bringing count k - 1 to the scale of count k
+  std::vector<Real> ratios;
+  std::vector<long long> exponents;
+
+  void renormalize();
+  std::array<long double, 2> unscaled_product(int k, const TransitionMatrix &trailing) const;
+};
+
+// evaluates `evaluate(column)` with a double column starting at `initial`, and again with a long double one if the
+// double column is not precise enough. a DP of `max_count` steps whose error bound already exceeds the tolerance in
+// double runs in long double right away. both calls are compiled separately, so the kernels do not branch on the type
+template <class Evaluate>
+auto eval_with_adaptive_precision(int max_count, const std::array<long double, 2> &initial, Evaluate evaluate) {
+  if (ScaledColumn<double>::can_be_precise(max_count)) {
+    ScaledColumn<double> column(max_count, initial);
+    auto result = evaluate(column);
+    if (column.is_precise())
+      return result;
+    logger.debug("Scaled DP in double lost precision, recomputing in long double...");
+  }
+
+  ScaledColumn<long double> wide_column(max_count, initial);
+  return evaluate(wide_column);
+}
+
+#endif // SCALEDCOLUMN_H
@@ -1,7 +1,14 @@
 #include "SegTree.hpp"
 #include "../Interval/Section.hpp"
+#include "../Profiler/Profiler.hpp"
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <queue>
+#include <tuple>
+
+// subtrees with more leaves than this are built as separate tasks
+const int SEGTREE_TASK_CUTOFF = 64;
 
 template <class T> SegTree<T>::SegTree() {}
 
@@ -26,8 +33,14 @@ template <class T> void SegTree<T>::_build(const std::vector<T> &values, int x,
   }
 
   int m = (lx + rx) / 2;
-  _build(values, 2 * x + 1, lx, m);
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp task shared(values) if (rx - lx > SEGTREE_TASK_CUTOFF)
+  {
+    ProfileScope scope(context);
+    _build(values, 2 * x + 1, lx, m);
+  }
   _build(values, 2 * x + 2, m, rx);
+#pragma omp taskwait
   t[x] = this->op(this->t[2 * x + 1], this->t[2 * x + 2], this->markov_chain);
 }
 
@@ -124,5 +137,136 @@ template <class T> T SegTree<T>::_query(int l, int r, int x, int lx, int rx) {
 
 template <class T> T SegTree<T>::query(int l, int r) { return this->_query(l, r, 0, 0, this->N); }
 
+// every range [l, r) that isn't a single node is split at the highest node x whose middle lies inside it into a
+// suffix of the left child and a prefix of the right child. a suffix [l, rx) of a node is the join of a suffix of its
+// left child with the whole right child, unless l is in the right child, so it needs one join per level where l goes
+// left. these joins are keyed by (node, l), so ranges starting at the same position share them
+template <class T>
+void SegTree<T>::collect_suffix_joins(int x, int lx, int rx, int l,
+                                      std::vector<std::vector<std::pair<int, int>>> &keys) {
+  for (int depth = std::bit_width((unsigned)x + 1) - 1; l > lx; depth++) {
+    int m = (lx + rx) / 2;
+    if (l >= m) {
+      x = 2 * x + 2, lx = m;
+    } else {
+      keys[depth].push_back({x, l});
+      x = 2 * x + 1, rx = m;
+    }
+  }
+}
+
+template <class T>
+void SegTree<T>::collect_prefix_joins(int x, int lx, int rx, int r,
+                                      std::vector<std::vector<std::pair<int, int>>> &keys) {
+  for (int depth = std::bit_width((unsigned)x + 1) - 1; r < rx; depth++) {
+    int m = (lx + rx) / 2;
+    if (r <= m) {
+      x = 2 * x + 1, rx = m;
+    } else {
+      keys[depth].push_back({x, r});
+      x = 2 * x + 2, lx = m;
+    }
+  }
+}
+
+template <class T> const T &SegTree<T>::get_suffix(int x, int lx, int rx, int l, const PartialJoins &suffixes) {
+  while (l > lx) {
+    int m = (lx + rx) / 2;
+    if (l < m)
+      return suffixes.at({x, l});
+    x = 2 * x + 2, lx = m;
+  }
+  return this->t[x];
+}
+
+template <class T> const T &SegTree<T>::get_prefix(int x, int lx, int rx, int r, const PartialJoins &prefixes) {
+  while (r < rx) {
+    int m = (lx + rx) / 2;
+    if (r > m)
+      return prefixes.at({x, r});
+    x = 2 * x + 1, rx = m;
+  }
+  return this->t[x];
+}
+
+// computes the collected joins from the deepest level up, joins of one level only depend on the levels below
+template <class T>
+void SegTree<T>::compute_partial_joins(std::vector<std::vector<std::pair<int, int>>> &keys, PartialJoins &joins,
+                                       bool suffix) {
+  for (std::vector<std::pair<int, int>> &level_keys : keys) {
+    std::sort(level_keys.begin(), level_keys.end());
+    level_keys.erase(std::unique(level_keys.begin(), level_keys.end()), level_keys.end());
+    for (const std::pair<int, int> &key : level_keys)
+      joins.emplace(key, this->neutral_element);
+  }
+
+  for (int depth = (int)keys.size() - 1; depth >= 0; depth--) {
+    const std::vector<std::pair<int, int>> &level_keys = keys[depth];
+    int width = this->N >> depth;
+    ProfileContext context = ProfileScope::current_context();
+
+#pragma omp taskloop default(shared)
+    for (size_t idx = 0; idx < level_keys.size(); idx++) {
+      ProfileScope scope(context);
+      auto [x, pos] = level_keys[idx];
+      int lx = (x + 1 - (1 << depth)) * width, m = lx + width / 2, rx = lx + width;
+      T &result = joins.find(level_keys[idx])->second;
+      if (suffix)
+        result = this->op(get_suffix(2 * x + 1, lx, m, pos, joins), this->t[2 * x + 2], this->markov_chain);
+      else
+        result = this->op(this->t[2 * x + 1], get_prefix(2 * x + 2, m, rx, pos, joins), this->markov_chain);
+    }
+  }
+}
+
+template <class T> std::vector<T> SegTree<T>::query_batch(const std::vector<std::pair<int, int>> &ranges) {
+  int levels = std::bit_width((unsigned)this->N);
+  std::vector<std::vector<std::pair<int, int>>> suffix_keys(levels), prefix_keys(levels);
+
+  // (node, lx, rx) of the node where every range is answered
+  std::vector<std::tuple<int, int, int>> split_nodes(ranges.size());
+  for (size_t idx = 0; idx < ranges.size(); idx++) {
+    auto [l, r] = ranges[idx];
+    int x = 0, lx = 0, rx = this->N;
+    while (l < r && !(l <= lx && rx <= r)) {
+      int m = (lx + rx) / 2;
+      if (r <= m) {
+        x = 2 * x + 1, rx = m;
+      } else if (l >= m) {
+        x = 2 * x + 2, lx = m;
+      } else {
+        collect_suffix_joins(2 * x + 1, lx, m, l, suffix_keys);
+        collect_prefix_joins(2 * x + 2, m, rx, r, prefix_keys);
+        break;
+      }
+    }
+    split_nodes[idx] = {x, lx, rx};
+  }
+
+  PartialJoins suffixes, prefixes;
+  compute_partial_joins(suffix_keys, suffixes, true);
+  compute_partial_joins(prefix_keys, prefixes, false);
+
+  std::vector<T> results(ranges.size(), this->neutral_element);
+  ProfileContext context = ProfileScope::current_context();
+#pragma omp taskloop default(shared)
+  for (size_t idx = 0; idx < ranges.size(); idx++) {
+    ProfileScope scope(context);
+    auto [l, r] = ranges[idx];
+    auto [x, lx, rx] = split_nodes[idx];
+    if (l >= r)
+      continue;
+    if (l <= lx && rx <= r) {
+      results[idx] = this->t[x];
+      continue;
+    }
+    int m = (lx + rx) / 2;
+    results[idx] = this->op(get_suffix(2 * x + 1, lx, m, l, suffixes), get_prefix(2 * x + 2, m, rx, r, prefixes),
+                            this->markov_chain);
+  }
+
+  return results;
+}
+
 template class SegTree<int>;
 template class SegTree<Section>;
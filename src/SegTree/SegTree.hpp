@@ -4,6 +4,8 @@
 #include "../MarkovChain/MarkovChain.hpp"
 
 #include <functional>
+#include <map>
+#include <utility>
 #include <vector>
 
 template <class T> class SegTree {
@@ -16,6 +18,9 @@ public:
 
   void set(int idx, T el);
   T query(int l, int r); // returns combined elements from interval [l, r) with the operation provided
+  // same as calling query for every range, but the ranges are answered in parallel and equal partial joins are
+  // computed only once
+  std::vector<T> query_batch(const std::vector<std::pair<int, int>> &ranges);
   void dump();
 
 private:
@@ -25,9 +30,18 @@ private:
   T neutral_element;
   MarkovChain markov_chain;
 
+  // partial joins of a node, keyed by (node, l) for suffixes [l, rx) and by (node, r) for prefixes [lx, r)
+  using PartialJoins = std::map<std::pair<int, int>, T>;
+
   void init(int n);
   void _build(const std::vector<T> &values, int x, int lx, int rx);
   T _query(int l, int r, int x, int lx, int rx);
+
+  void collect_suffix_joins(int x, int lx, int rx, int l, std::vector<std::vector<std::pair<int, int>>> &keys);
+  void collect_prefix_joins(int x, int lx, int rx, int r, std::vector<std::vector<std::pair<int, int>>> &keys);
+  const T &get_suffix(int x, int lx, int rx, int l, const PartialJoins &suffixes);
+  const T &get_prefix(int x, int lx, int rx, int r, const PartialJoins &prefixes);
+  void compute_partial_joins(std::vector<std::vector<std::pair<int, int>>> &keys, PartialJoins &joins, bool suffix);
 };
 
 #endif // SEGTREE_H
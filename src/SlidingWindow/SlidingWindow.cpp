@@ -0,0 +1,53 @@
+#include "SlidingWindow.hpp"
+#include "../Interval/Section.hpp"
+#include "../Logger/Logger.hpp"
+
+template <class T>
+SlidingWindow<T>::SlidingWindow(SlidingWindowOperation operation, T neutral_element, const MarkovChain &mc)
+    : op(operation), neutral_element(neutral_element), markov_chain(mc), back_aggregate(neutral_element) {}
+
+template <class T> void SlidingWindow<T>::push(const T &el) {
+  back_aggregate = back_elements.empty() ? el : this->op(back_aggregate, el, this->markov_chain);
+  back_elements.push_back(el);
+}
+
+// moves all elements of the back stack to the front one, newest first, so the oldest one ends up on top
+template <class T> void SlidingWindow<T>::flip() {
+  for (size_t idx = back_elements.size(); idx-- > 0;) {
+    if (front_aggregates.empty())
+      front_aggregates.push_back(back_elements[idx]);
+    else
+      front_aggregates.push_back(this->op(back_elements[idx], front_aggregates.back(), this->markov_chain));
+  }
+  back_elements.clear();
+  back_aggregate = this->neutral_element;
+}
+
+template <class T> void SlidingWindow<T>::pop() {
+  if (front_aggregates.empty())
+    flip();
+  if (front_aggregates.empty()) {
+    logger.error("Can't pop from an empty sliding window.");
+    exit(1);
+  }
+  front_aggregates.pop_back();
+}
+
+template <class T> T SlidingWindow<T>::query() const {
+  if (front_aggregates.empty())
+    return back_aggregate;
+  if (back_elements.empty())
+    return front_aggregates.back();
+  return this->op(front_aggregates.back(), back_aggregate, this->markov_chain);
+}
+
+template <class T> size_t SlidingWindow<T>::size() const { return front_aggregates.size() + back_elements.size(); }
+
+template <class T> void SlidingWindow<T>::clear() {
+  front_aggregates.clear();
+  back_elements.clear();
+  back_aggregate = this->neutral_element;
+}
+
+template class SlidingWindow<int>;
+template class SlidingWindow<Section>;
@@ -0,0 +1,36 @@
+#ifndef SLIDINGWINDOW_H
+#define SLIDINGWINDOW_H
+
+#include "../MarkovChain/MarkovChain.hpp"
+
+#include <functional>
+#include <vector>
+
+// queue that returns the combination of all of its elements in order with amortized O(1) operations, the operation
+// only needs to be associative. kept as two stacks: the front one holds the oldest elements together with the
+// combination of each of them with all the newer elements of the front stack, the back one holds the newest elements
+// and the combination of all of them
+template <class T> class SlidingWindow {
+public:
+  using SlidingWindowOperation = std::function<T(T, T, const MarkovChain &)>;
+
+  SlidingWindow(SlidingWindowOperation operation, T neutral_element, const MarkovChain &mc);
+
+  void push(const T &el);
+  void pop();
+  T query() const; // returns combined elements from oldest to newest with the operation provided
+  size_t size() const;
+  void clear();
+
+private:
+  SlidingWindowOperation op;
+  T neutral_element;
+  MarkovChain markov_chain;
+
+  std::vector<T> front_aggregates, back_elements;
+  T back_aggregate;
+
+  void flip();
+};
+
+#endif // SLIDINGWINDOW_H
@@ -1,3 +1,4 @@
+#include "../DisjointSparseTable/DisjointSparseTable.hpp"
 #include "../SegTree/SegTree.hpp"
 #include <gtest/gtest.h>
 
@@ -8,3 +9,60 @@ TEST(SegTreeBasicOps, Sum) {
   ASSERT_EQ(5, t.query(1, 2));
   ASSERT_EQ(-9, t.query(4, 8));
 }
+
+TEST(SegTreeBasicOps, BatchQueryMatchesQuery) {
+  MarkovChain mc;
+  std::vector<int> values;
+  for (int idx = 0; idx < 37; idx++)
+    values.push_back((idx * 7919) % 23 - 11);
+
+  // first non-zero element is associative but not commutative, so the order of joins is checked as well
+  std::vector<SegTree<int>::SegTreeOperation> operations = {
+      [](int x, int y, const MarkovChain &mc) { return x + y; },
+      [](int x, int y, const MarkovChain &mc) { return x != 0 ? x : y; }};
+  for (auto operation : operations) {
+    SegTree<int> t(operation, 0, values, mc);
+
+    std::vector<std::pair<int, int>> ranges;
+    for (int l = 0; l <= (int)values.size(); l++)
+      for (int r = l; r <= (int)values.size(); r++)
+        ranges.push_back({l, r});
+    // duplicated ranges share their partial joins
+    ranges.push_back({3, 30});
+    ranges.push_back({3, 30});
+
+    std::vector<int> results = t.query_batch(ranges);
+    ASSERT_EQ(results.size(), ranges.size());
+    for (size_t idx = 0; idx < ranges.size(); idx++)
+      ASSERT_EQ(results[idx], t.query(ranges[idx].first, ranges[idx].second));
+  }
+}
+
+TEST(DisjointSparseTableBasicOps, MatchesSegTree) {
+  MarkovChain mc;
+  auto first_non_zero = [](int x, int y, const MarkovChain &mc) { return x != 0 ? x : y; };
+  for (int n : {1, 2, 5, 16, 37}) {
+    std::vector<int> values;
+    for (int idx = 0; idx < n; idx++)
+      values.push_back((idx * 7919) % 23 - 11);
+
+    SegTree<int> st(first_non_zero, 0, values, mc);
+    DisjointSparseTable<int> table(first_non_zero, 0, values, mc);
+    for (int l = 0; l <= n; l++)
+      for (int r = l; r <= n; r++)
+        ASSERT_EQ(st.query(l, r), table.query(l, r));
+
+    // every entry is a range of one to n elements
+    long double entries = DisjointSparseTable<int>::estimate_size(n, [](int a, int b) { return 1.L; });
+    long double elements = DisjointSparseTable<int>::estimate_size(n, [](int a, int b) { return (long double)b - a; });
+    ASSERT_LE(entries, elements);
+    ASSERT_LE(elements, entries * n);
+
+    // ranges up to 3 elements long only need the entries up to 3 elements long
+    DisjointSparseTable<int> short_table(first_non_zero, 0, values, mc, 3);
+    for (int l = 0; l <= n; l++)
+      for (int r = l; r <= std::min(n, l + 3); r++)
+        ASSERT_EQ(st.query(l, r), short_table.query(l, r));
+    ASSERT_LE(DisjointSparseTable<int>::estimate_size(n, [](int a, int b) { return 1.L; }, 3), entries);
+  }
+}
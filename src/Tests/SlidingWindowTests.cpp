@@ -0,0 +1,43 @@
+#include "../SlidingWindow/SlidingWindow.hpp"
+#include <gtest/gtest.h>
+
+TEST(SlidingWindowBasicOps, Sum) {
+  MarkovChain mc;
+  SlidingWindow<int> w([](int x, int y, const MarkovChain &mc) { return x + y; }, 0, mc);
+  ASSERT_EQ(0, w.query());
+  for (int value : {1, 5, 10, -1})
+    w.push(value);
+  ASSERT_EQ(15, w.query());
+  w.pop();
+  ASSERT_EQ(14, w.query());
+  w.push(7);
+  w.pop();
+  ASSERT_EQ(16, w.query());
+  ASSERT_EQ(3u, w.size());
+}
+
+TEST(SlidingWindowBasicOps, KeepsOrder) {
+  MarkovChain mc;
+  // appending digits is associative but not commutative
+  auto append = [](int x, int y, const MarkovChain &mc) {
+    int shift = 1;
+    while (shift <= y)
+      shift *= 10;
+    return x * shift + y;
+  };
+  SlidingWindow<int> w(append, 0, mc);
+
+  std::vector<int> values = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  size_t begin = 0, end = 0;
+  for (auto [next_begin, next_end] : std::vector<std::pair<size_t, size_t>>{{0, 3}, {1, 4}, {2, 6}, {5, 7}, {6, 9}}) {
+    for (; end < next_end; end++)
+      w.push(values[end]);
+    for (; begin < next_begin; begin++)
+      w.pop();
+
+    int expected = 0;
+    for (size_t idx = begin; idx < end; idx++)
+      expected = append(expected, values[idx], mc);
+    ASSERT_EQ(expected, w.query());
+  }
+}
@@ -1,10 +1,29 @@
+#include "../Convolution/Convolution.hpp"
+#include "../Generator/Generator.hpp"
 #include "../Helpers/Helpers.hpp"
+#include "../Interval/ChrDictionary.hpp"
 #include "../Interval/Interval.hpp"
+#include "../Interval/IntervalsView.hpp"
+#include "../IntervalsLoader/IntervalsCache.hpp"
+#include "../IntervalsLoader/IntervalsLoader.hpp"
+#include "../Model/BasesModel.hpp"
 #include "../Model/WindowModel.hpp"
+#include "../ParallelSort/ParallelSort.hpp"
+#include "../Profiler/Profiler.hpp"
+#include "../ScaledColumn/ScaledColumn.hpp"
 #include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest-death-test.h>
 #include <gtest/gtest.h>
 #include <math.h>
+#include <memory>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <type_traits>
 
 TEST(MergeNonDisjointIntervalsTest, EmptyVector) {
   std::vector<Interval> intervals;
@@ -75,6 +94,405 @@ TEST(GetStationaryDistributionTest, SumsToOne) {
   EXPECT_NEAR(sum, 1.0L, 1e-10L);
 }
 
+TEST(MarkovChainPowerTest, MatchesBinaryExponentiation) {
+  std::vector<Interval> query_intervals = {{"chr1", 100, 200}, {"chr1", 500, 550}, {"chr1", 900, 1000}};
+  MarkovChain mc(100000, query_intervals);
+  for (long long n : {0LL, 1LL, 2LL, 7LL, 100LL, 12345LL, 1000000LL}) {
+    TransitionMatrix T_pow = mc.power_T(n), T_expected = binary_exponentiation(mc.get_T(), n);
+    TransitionMatrix D_pow = mc.power_T_MOD(n), D_expected = binary_exponentiation(mc.get_T_MOD(), n);
+    for (int i : {0, 1}) {
+      for (int j : {0, 1}) {
+        EXPECT_NEAR(T_pow[i][j], T_expected[i][j], 1e-12L);
+        EXPECT_NEAR(D_pow[i][j], D_expected[i][j], 1e-12L);
+      }
+    }
+  }
+}
+
+TEST(MarkovChainPowerTest, ConvergesToStationaryDistribution) {
+  std::vector<Interval> query_intervals = {{"chr1", 100, 200}, {"chr1", 500, 550}, {"chr1", 900, 1000}};
+  MarkovChain mc(100000, query_intervals);
+  TransitionMatrix T_pow = mc.power_T(100000000);
+  StationaryDistribution pi = mc.get_stationary_distribution();
+  for (int i : {0, 1}) {
+    EXPECT_NEAR(T_pow[i][0], pi[0], 1e-16L);
+    EXPECT_NEAR(T_pow[i][1], pi[1], 1e-16L);
+  }
+}
+
+TEST(MarkovChainPowerTest, FallsBackForNonStochasticMatrix) {
+  TransitionMatrix T = {{{{0.5L, 0.25L}}, {{0.25L, 0.5L}}}};
+  MarkovChain mc(T, T);
+  TransitionMatrix T_pow = mc.power_T(5), T_expected = binary_exponentiation(T, 5);
+  for (int i : {0, 1})
+    for (int j : {0, 1})
+      EXPECT_EQ(T_pow[i][j], T_expected[i][j]);
+}
+
+TEST(BandedDPTest, ZeroEpsilonMatchesDirect) {
+  std::vector<Interval> ref_intervals = load_intervals("test_data/g24_8.ref.tsv");
+  std::vector<Interval> query_intervals = load_intervals("test_data/g24_8.query.tsv");
+  ref_intervals = merge_non_disjoint_intervals(ref_intervals);
+  query_intervals = merge_non_disjoint_intervals(query_intervals);
+  MarkovChain mc(1000000, query_intervals);
+
+  long double dropped_mass = 0;
+  std::vector<long double> expected = Model::eval_probs_single_chr_direct(ref_intervals, query_intervals, mc, 1000000);
+  std::vector<long double> banded = Model::eval_probs_single_chr_banded(ref_intervals, mc, 1000000, 0, dropped_mass);
+  EXPECT_TRUE(compare_logprobs_vectors(expected, banded));
+  EXPECT_EQ(dropped_mass, 0);
+}
+
+TEST(BandedDPTest, DroppedMassIsBoundedByEpsilon) {
+  std::vector<Interval> ref_intervals = load_intervals("test_data/g24_8.ref.tsv");
+  std::vector<Interval> query_intervals = load_intervals("test_data/g24_8.query.tsv");
+  ref_intervals = merge_non_disjoint_intervals(ref_intervals);
+  query_intervals = merge_non_disjoint_intervals(query_intervals);
+  MarkovChain mc(1000000, query_intervals);
+
+  long double epsilon = 1e-9, dropped_mass = 0;
+  std::vector<long double> expected = Model::eval_probs_single_chr_direct(ref_intervals, query_intervals, mc, 1000000);
+  std::vector<long double> banded =
+      Model::eval_probs_single_chr_banded(ref_intervals, mc, 1000000, epsilon, dropped_mass);
+  EXPECT_GT(dropped_mass, 0);
+  EXPECT_LE(dropped_mass, epsilon);
+  EXPECT_TRUE(compare_logprobs_vectors(expected, banded, epsilon));
+}
+
+TEST(BandedDPTest, GenomeWideDroppedMassIsBoundedByEpsilon) {
+  std::vector<Interval> ref_intervals, query_intervals;
+  ChrSizesMap chr_sizes;
+  // the same chromosome four times, each of them would drop about epsilon with the whole budget
+  for (std::string chr_name : {"chr1", "chr2", "chr3", "chr4"}) {
+    chr_sizes[chr_name] = 10000000;
+    for (Interval interval : merge_non_disjoint_intervals(load_intervals("test_data/g24_8.ref.tsv")))
+      ref_intervals.push_back({chr_name, interval.begin, interval.end});
+    for (Interval interval : merge_non_disjoint_intervals(load_intervals("test_data/g24_8.query.tsv")))
+      query_intervals.push_back({chr_name, interval.begin, interval.end});
+  }
+
+  long double epsilon = 1e-9;
+  std::vector<long double> expected = Model(ref_intervals, query_intervals, chr_sizes).eval_probs(0);
+  Model model(ref_intervals, query_intervals, chr_sizes, epsilon);
+  std::vector<long double> probs = model.eval_probs(0);
+  EXPECT_GT(model.dropped_mass, 0);
+  EXPECT_LE(model.dropped_mass, epsilon);
+  probs.resize(expected.size(), -std::numeric_limits<long double>::infinity());
+  EXPECT_TRUE(compare_logprobs_vectors(expected, probs, epsilon));
+}
+
+TEST(ScaledDPTest, MatchesDirect) {
+  std::vector<Interval> ref_intervals = load_intervals("test_data/g24_8.ref.tsv");
+  std::vector<Interval> query_intervals = load_intervals("test_data/g24_8.query.tsv");
+  ref_intervals = merge_non_disjoint_intervals(ref_intervals);
+  query_intervals = merge_non_disjoint_intervals(query_intervals);
+  MarkovChain mc(1000000, query_intervals);
+
+  std::vector<long double> expected = Model::eval_probs_single_chr_direct(ref_intervals, query_intervals, mc, 1000000);
+  std::vector<long double> scaled = Model::eval_probs_single_chr_scaled(ref_intervals, query_intervals, mc, 1000000);
+  ASSERT_EQ(expected.size(), scaled.size());
+  // below this the direct DP itself loses precision
+  for (size_t k = 0; k < expected.size(); k++) {
+    if (expected[k] > -700) {
+      EXPECT_NEAR(scaled[k], expected[k], 1e-9L * std::max(1.L, std::abs(expected[k])));
+    }
+  }
+}
+
+TEST(ScaledDPTest, FarTailsDoNotUnderflow) {
+  // a query covering most of the chromosome hits almost every reference interval
+  std::vector<Interval> ref_intervals, query_intervals;
+  for (long long pos = 0; pos < 300000; pos += 100) {
+    ref_intervals.push_back({"", pos + 20, pos + 70});
+    query_intervals.push_back({"", pos + 5, pos + 95});
+  }
+  MarkovChain mc(300000, query_intervals);
+
+  std::vector<long double> scaled = Model::eval_probs_single_chr_scaled(ref_intervals, query_intervals, mc, 300000);
+  long double total = 0;
+  for (long double logprob : scaled) {
+    EXPECT_TRUE(std::isfinite(logprob));
+    total += std::exp(logprob);
+  }
+  EXPECT_NEAR(total, 1, 1e-9);
+  // far below the smallest long double
+  EXPECT_LT(scaled[0], -12000);
+}
+
+TEST(ScaledDPTest, LongDoubleMatchesDouble) {
+  std::mt19937 rng(17);
+  std::uniform_real_distribution<long double> uniform(0, 0.5);
+  ScaledColumn<double> col(2000, {0.3, 0.7});
+  ScaledColumn<long double> wide_col(2000, {0.3, 0.7});
+  for (int j = 0; j < 2000; j++) {
+    // every row of dont_hit + hit sums to one, like in the DP
+    TransitionMatrix dont_hit, hit;
+    for (int s : {0, 1}) {
+      for (int t : {0, 1}) {
+        dont_hit[s][t] = uniform(rng);
+        hit[s][t] = 0.5 - dont_hit[s][t];
+      }
+    }
+    col.advance(dont_hit, hit);
+    wide_col.advance(dont_hit, hit);
+  }
+
+  EXPECT_TRUE(col.is_precise());
+  EXPECT_TRUE(wide_col.is_precise());
+  TransitionMatrix identity = {{{1, 0}, {0, 1}}};
+  for (int k = 0; k <= 2000; k++) {
+    long double expected = wide_col.log_prob(k, identity);
+    EXPECT_NEAR(col.log_prob(k, identity), expected, 1e-9L * std::max(1.L, std::abs(expected)));
+  }
+}
+
+TEST(ScaledDPTest, FallsBackToLongDouble) {
+  // hits of 10^-250 put neighbouring counts further apart than the exponents of a double column may be
+  TransitionMatrix identity = {{{1, 0}, {0, 1}}}, rare_hit = {{{1e-250L, 0}, {0, 1e-250L}}};
+  auto evaluate = [&](auto &col) {
+    col.advance(identity, rare_hit);
+    return std::make_pair(col.log_prob(1, identity), col.is_precise());
+  };
+
+  ScaledColumn<double> col(1, {1, 0});
+  EXPECT_FALSE(evaluate(col).second);
+
+  std::pair<long double, bool> result = eval_with_adaptive_precision(1, {1, 0}, evaluate);
+  EXPECT_TRUE(result.second);
+  EXPECT_NEAR(result.first, std::log(1e-250L), 1e-9);
+}
+
+TEST(ScaledDPTest, LongDPsStartInLongDouble) {
+  // the error bound of a double column exceeds the tolerance after about 90000 steps
+  int calls = 0;
+  auto evaluate = [&calls](auto &col) {
+    calls++;
+    return std::is_same_v<std::remove_reference_t<decltype(col)>, ScaledColumn<long double>>;
+  };
+  EXPECT_FALSE(eval_with_adaptive_precision(1000, {1, 0}, evaluate));
+  EXPECT_TRUE(eval_with_adaptive_precision(200000, {1, 0}, evaluate));
+  EXPECT_EQ(calls, 2);
+  EXPECT_TRUE(ScaledColumn<long double>::can_be_precise(200000));
+}
+
+TEST(GeneratorTest, SameSeedGivesSameIntervals) {
+  ChrSizesVector chr_sizes = {{"gen1", 200000}, {"gen2", 50000}};
+  std::vector<std::optional<MarkovChain>> chains(2, markov_chain_from_density(0.2, 100));
+
+  std::vector<Interval> intervals = generate_intervals(chr_sizes, chains, 7, 0);
+  EXPECT_EQ(generate_intervals(chr_sizes, chains, 7, 0), intervals);
+  EXPECT_NE(generate_intervals(chr_sizes, chains, 8, 0), intervals);
+  EXPECT_NE(generate_intervals(chr_sizes, chains, 7, 1), intervals);
+  EXPECT_TRUE(std::is_sorted(intervals.begin(), intervals.end()));
+  // runs of state 1 never touch, so the output is already merged
+  for (size_t idx = 1; idx < intervals.size(); idx++) {
+    if (intervals[idx].chr_id == intervals[idx - 1].chr_id) {
+      EXPECT_GT(intervals[idx].begin, intervals[idx - 1].end);
+    }
+  }
+
+  // chromosomes without a chain stay empty
+  chains[0].reset();
+  for (const Interval &interval : generate_intervals(chr_sizes, chains, 7, 0))
+    EXPECT_EQ(interval.get_chr_name(), "gen2");
+}
+
+TEST(GeneratorTest, MatchesDensityAndLength) {
+  ChrSizesVector chr_sizes = {{"gen1", 10000000}};
+  std::vector<Interval> intervals = generate_intervals(chr_sizes, {markov_chain_from_density(0.3, 200)}, 3, 0);
+
+  long long covered = 0;
+  for (const Interval &interval : intervals) {
+    EXPECT_GE(interval.begin, 0);
+    EXPECT_LE(interval.end, chr_sizes[0].second);
+    covered += interval.length();
+  }
+  EXPECT_NEAR((long double)covered / chr_sizes[0].second, 0.3, 0.01);
+  EXPECT_NEAR((long double)covered / intervals.size(), 200, 5);
+
+  // the chain fitted to the sample is close to the one it was sampled from
+  MarkovChain fitted = *fit_markov_chains(chr_sizes, intervals)[0];
+  EXPECT_NEAR(fitted.get_stationary_distribution()[1], 0.3, 0.01);
+}
+
+TEST(ProfilerTest, ReportsNestedPhasesAndCounters) {
+  profiler.reset();
+  profiler.enable();
+  {
+    ProfileScope splitting_scope(Phase::SECTION_SPLITTING, ChrDictionary::get_id("profiled"));
+    profiler.count(Counter::BYTES_READ, 5);
+    // the nested scope belongs to the same chromosome and takes the counters while it runs
+    ProfileScope build_scope(Phase::SEGTREE_BUILD);
+    profiler.count(Counter::JOINS, 3);
+  }
+
+  std::string file_path = (std::filesystem::temp_directory_path() / "emcdp_profile_test.json").string();
+  profiler.write_report(file_path);
+  std::stringstream report;
+  report << std::ifstream(file_path).rdbuf();
+  std::filesystem::remove(file_path);
+
+  std::string counters = "\"calls\": 1, \"counters\": \\{\"dp_cells\": 0, \"matrix_powers\": 0, ";
+  EXPECT_TRUE(std::regex_search(
+      report.str(), std::regex("\"phase\": \"section_splitting\"[^\\]]*\\][^\\]]*\"chr\": \"profiled\"[^}]*" +
+                               counters + "\"joins\": 0, \"bytes_read\": 5\\}")));
+  EXPECT_TRUE(std::regex_search(
+      report.str(), std::regex("\"phase\": \"segtree_build\"[^\\]]*\\][^\\]]*\"chr\": \"profiled\"[^}]*" +
+                               counters + "\"joins\": 3, \"bytes_read\": 0\\}")));
+
+  // the other tests run with the profiler disabled, as without --profile
+  profiler.disable();
+  profiler.reset();
+  EXPECT_FALSE(ProfileScope::current_context().active);
+}
+
+TEST(BasesModelTest, MatchesDPOverSingleBases) {
+  std::mt19937 rng(11);
+  long long chr_size = 4000;
+  // runs longer than a stretch and a run starting at zero included
+  std::vector<Interval> ref_intervals = {{"", 0, 3}, {"", 10, 310}};
+  for (long long pos = 330; pos < 700;) {
+    long long length = 1 + rng() % 20;
+    ref_intervals.push_back({"", pos, pos + length});
+    pos += length + rng() % 30;
+  }
+  std::vector<Interval> query_intervals;
+  for (long long pos = rng() % 50; pos < chr_size - 100;) {
+    long long length = 1 + rng() % 60;
+    query_intervals.push_back({"", pos, pos + length});
+    pos += length + 1 + rng() % 80;
+  }
+  MarkovChain mc(chr_size, query_intervals);
+
+  std::vector<long double> expected =
+      Model::eval_probs_single_chr_direct(split_intervals_into_ones(ref_intervals), query_intervals, mc, chr_size);
+  long double dropped_mass = 0;
+  std::vector<long double> probs =
+      BasesModel::eval_probs_single_chr_bases(ref_intervals, mc, chr_size, 0, dropped_mass);
+  ASSERT_EQ(expected.size(), probs.size());
+  for (size_t k = 0; k < probs.size(); k++)
+    EXPECT_NEAR(expected[k], probs[k], 1e-9);
+  EXPECT_EQ(dropped_mass, 0);
+}
+
+TEST(BasesModelTest, GenomeWideMatchesModelOverSingleBases) {
+  ChrSizesMap chr_sizes = {{"chr1", 3000}, {"chr2", 2000}};
+  std::mt19937 rng(3);
+  std::vector<Interval> ref_intervals, query_intervals;
+  for (const auto &[chr_name, chr_size] : chr_sizes) {
+    for (long long pos = rng() % 40; pos < chr_size - 100; pos += 1 + rng() % 200) {
+      long long length = 1 + rng() % 15;
+      ref_intervals.push_back({chr_name, pos, pos + length});
+      pos += length;
+    }
+    for (long long pos = rng() % 40; pos < chr_size - 100; pos += 1 + rng() % 80) {
+      long long length = 1 + rng() % 60;
+      query_intervals.push_back({chr_name, pos, pos + length});
+      pos += length;
+    }
+  }
+  sort_intervals(ref_intervals);
+  sort_intervals(query_intervals);
+
+  // the query chain has to be estimated from single bases too, as when the query is split before the model
+  std::vector<long double> expected =
+      Model(split_intervals_into_ones(ref_intervals), split_intervals_into_ones(query_intervals), chr_sizes)
+          .eval_probs(0);
+  std::vector<long double> probs = BasesModel(ref_intervals, query_intervals, chr_sizes).eval_probs(0);
+  EXPECT_TRUE(compare_logprobs_vectors(expected, probs, 1e-9));
+}
+
+TEST(BasesModelTest, DroppedMassIsBoundedByEpsilon) {
+  std::vector<Interval> ref_intervals = merge_non_disjoint_intervals(load_intervals("test_data/g24_8.ref.tsv"));
+  std::vector<Interval> query_intervals = merge_non_disjoint_intervals(load_intervals("test_data/g24_8.query.tsv"));
+  ref_intervals.resize(50);
+  MarkovChain mc(1000000, query_intervals);
+
+  long double epsilon = 1e-9, dropped_mass = 0, exact_dropped_mass = 0;
+  std::vector<long double> expected =
+      BasesModel::eval_probs_single_chr_bases(ref_intervals, mc, 1000000, 0, exact_dropped_mass);
+  std::vector<long double> probs =
+      BasesModel::eval_probs_single_chr_bases(ref_intervals, mc, 1000000, epsilon, dropped_mass);
+  EXPECT_GT(dropped_mass, 0);
+  EXPECT_LE(dropped_mass, epsilon);
+  EXPECT_TRUE(compare_logprobs_vectors(expected, probs, epsilon));
+}
+
+TEST(CountOverlappingBasesTest, MatchesSingleBaseOverlaps) {
+  std::mt19937 rng(5);
+  auto random_intervals = [&rng](int count) {
+    std::vector<Interval> intervals;
+    for (int idx = 0; idx < count; idx++) {
+      long long begin = rng() % 300;
+      intervals.push_back({idx % 2 ? "chr1" : "chr2", begin, begin + 1 + (long long)(rng() % 30)});
+    }
+    return merge_non_disjoint_intervals(intervals);
+  };
+  for (int test_idx = 0; test_idx < 50; test_idx++) {
+    std::vector<Interval> ref = random_intervals(rng() % 30), query = random_intervals(rng() % 30);
+    EXPECT_EQ(count_overlapping_bases(ref, query),
+              count_overlaps(split_intervals_into_ones(ref), split_intervals_into_ones(query)));
+  }
+}
+
+std::vector<long double> binomial_logprobs(int n, long double p) {
+  std::vector<long double> logprobs(n + 1);
+  for (int k = 0; k <= n; k++)
+    logprobs[k] = std::lgamma((long double)n + 1) - std::lgamma((long double)k + 1) -
+                  std::lgamma((long double)n - k + 1) + k * std::log(p) + (n - k) * std::log1p(-p);
+  return logprobs;
+}
+
+std::vector<long double> convolve_logprobs_naive(const std::vector<long double> &a, const std::vector<long double> &b) {
+  std::vector<long double> result(a.size() + b.size() - 1);
+  for (size_t k = 0; k < result.size(); k++) {
+    std::vector<long double> accum;
+    for (size_t i = 0; i < a.size(); i++)
+      if (k >= i && k - i < b.size())
+        accum.push_back(a[i] + b[k - i]);
+    result[k] = logsumexp(accum);
+  }
+  return result;
+}
+
+TEST(ConvolveLogprobsTest, MatchesNaiveConvolution) {
+  std::vector<std::pair<std::vector<long double>, std::vector<long double>>> cases = {
+      {binomial_logprobs(3000, 0.3), binomial_logprobs(2000, 0.01)},
+      {binomial_logprobs(100, 0.9), binomial_logprobs(1500, 0.001)},
+      {binomial_logprobs(5, 0.5), binomial_logprobs(7, 0.2)}};
+  for (auto [a, b] : cases) {
+    std::vector<long double> expected = convolve_logprobs_naive(a, b), result = convolve_logprobs(a, b);
+    ASSERT_EQ(expected.size(), result.size());
+    for (size_t k = 0; k < expected.size(); k++)
+      EXPECT_NEAR(result[k], expected[k], 1e-9L * std::max(1.L, std::abs(expected[k])));
+  }
+}
+
+TEST(ConvolveLogprobsTest, KeepsZeroProbabilities) {
+  const long double ld_inf = std::numeric_limits<long double>::infinity();
+  std::vector<long double> a = {log(0.5L), -ld_inf, log(0.5L)}, b = {-ld_inf, log(0.25L), log(0.75L)};
+  std::vector<long double> result = convolve_logprobs(a, b);
+  std::vector<long double> expected = {-ld_inf, log(0.125L), log(0.375L), log(0.125L), log(0.375L)};
+  ASSERT_EQ(result.size(), expected.size());
+  EXPECT_EQ(result[0], -ld_inf);
+  for (size_t k = 1; k < expected.size(); k++)
+    EXPECT_NEAR(result[k], expected[k], 1e-15L);
+}
+
+TEST(JointLogprobsTest, ProductTreeMatchesSequentialFold) {
+  std::vector<std::vector<long double>> levels = {binomial_logprobs(700, 0.2), binomial_logprobs(3, 0.5),
+                                                  binomial_logprobs(2500, 0.05), binomial_logprobs(40, 0.7),
+                                                  binomial_logprobs(1, 0.1), binomial_logprobs(900, 0.4)};
+  std::vector<long double> expected = levels[0];
+  for (size_t idx = 1; idx < levels.size(); idx++)
+    expected = convolve_logprobs_naive(expected, levels[idx]);
+
+  std::vector<long double> result = joint_logprobs(levels);
+  ASSERT_EQ(expected.size(), result.size());
+  for (size_t k = 0; k < expected.size(); k++)
+    EXPECT_NEAR(result[k], expected[k], 1e-9L * std::max(1.L, std::abs(expected[k])));
+}
+
 TEST(GetWindowsIntervalsTest, NonOverlappingWindows) {
   std::vector<Interval> intervals = {{"", 1, 10}, {"", 20, 30}};
   std::vector<Interval> windows = {{"", 0, 15}, {"", 15, 50}};
@@ -119,6 +537,326 @@ TEST(GetWindowsIntervalsTest, NoIntervalsInWindow) {
   EXPECT_EQ(WindowModel::get_windows_intervals(windows, intervals), std::vector<std::vector<Interval>>{{}});
 }
 
+TEST(GetWindowsIntervalsTest, MatchesNaive) {
+  std::mt19937 rng(13);
+  for (int test_idx = 0; test_idx < 200; test_idx++) {
+    std::vector<Interval> intervals, windows;
+    long long pos = 0;
+    for (int idx = 0, count = rng() % 30; idx < count; idx++) {
+      pos += rng() % 4;
+      long long length = rng() % 6;
+      intervals.push_back({"", pos, pos + length});
+      pos += length;
+    }
+    for (int idx = 0, count = rng() % 20; idx < count; idx++) {
+      long long begin = rng() % (pos + 5);
+      windows.push_back({"", begin, begin + (long long)(rng() % 30)});
+    }
+    std::vector<std::vector<Interval>> expected = WindowModel::get_windows_intervals_naive(windows, intervals);
+    EXPECT_EQ(WindowModel::get_windows_intervals(windows, intervals), expected);
+
+    // views keep empty intervals, which preprocessing removes before any model runs
+    std::vector<IntervalsView> views = WindowModel::get_windows_intervals_views(windows, intervals);
+    ASSERT_EQ(views.size(), windows.size());
+    for (size_t windows_idx = 0; windows_idx < windows.size(); windows_idx++) {
+      std::vector<Interval> window_intervals = views[windows_idx].to_vector();
+      std::erase_if(window_intervals, [](const Interval &interval) { return interval.length() < 1; });
+      EXPECT_EQ(window_intervals, expected[windows_idx]);
+    }
+  }
+}
+
+// counts ref intervals overlapping any query interval by checking every pair
+static long long count_overlaps_naive(const std::vector<Interval> &ref, const std::vector<Interval> &query) {
+  long long overlap_count = 0;
+  for (const Interval &ref_interval : ref) {
+    bool overlaps = false;
+    for (const Interval &query_interval : query)
+      overlaps |= ref_interval.begin < query_interval.end && query_interval.begin < ref_interval.end;
+    overlap_count += overlaps;
+  }
+  return overlap_count;
+}
+
+TEST(CountOverlapsTest, MatchesNaive) {
+  std::mt19937 rng(7);
+  for (int test_idx = 0; test_idx < 200; test_idx++) {
+    // random sorted non-overlapping intervals, touching ones included
+    auto random_intervals = [&rng](int count) {
+      std::vector<Interval> intervals;
+      long long pos = 0;
+      for (int idx = 0; idx < count; idx++) {
+        pos += rng() % 4;
+        long long length = 1 + rng() % 6;
+        intervals.push_back({"", pos, pos + length});
+        pos += length;
+      }
+      return intervals;
+    };
+    std::vector<Interval> ref = random_intervals(rng() % 40), query = random_intervals(rng() % 40);
+    EXPECT_EQ(count_overlaps_single_chr(ref, query), count_overlaps_naive(ref, query));
+  }
+}
+
+TEST(CountOverlapsTest, ClippedViewsCountOnlyInsideRange) {
+  auto ref = std::make_shared<const IntervalColumns>(std::vector<Interval>{{"", 0, 10}, {"", 12, 20}});
+  auto query = std::make_shared<const IntervalColumns>(std::vector<Interval>{{"", 8, 13}});
+  auto ref_views = IntervalsView::split_by_ranges(ref, {{0, 9}, {9, 12}, {12, 30}}),
+       query_views = IntervalsView::split_by_ranges(query, {{0, 9}, {9, 12}, {12, 30}});
+  EXPECT_EQ(IntervalsView::count_overlaps(ref_views[0], query_views[0]), 1);
+  EXPECT_EQ(IntervalsView::count_overlaps(ref_views[1], query_views[1]), 1);
+  EXPECT_EQ(IntervalsView::count_overlaps(ref_views[2], query_views[2]), 1);
+}
+
+TEST(ParseIntervalsBufferTest, ChunksMatchLineByLineParsing) {
+  // large enough to be split into several chunks
+  std::string buffer;
+  std::vector<Interval> expected;
+  for (long long idx = 0; idx < 300000; idx++) {
+    std::string line = "chr" + std::to_string(idx / 50000) + "\t" + std::to_string(idx * 10) + "\t" +
+                       std::to_string(idx * 10 + 5 + idx % 3);
+    expected.push_back(parse_intervals_line(line));
+    buffer += line + (idx % 7 == 0 ? "\r\n" : "\n");
+  }
+  EXPECT_EQ(parse_intervals_buffer(buffer.data(), buffer.size()), expected);
+
+  buffer.pop_back();
+  EXPECT_EQ(parse_intervals_buffer(buffer.data(), buffer.size()), expected);
+}
+
+TEST(ParseIntervalsBufferTest, ClosedIntervalsAreConverted) {
+  std::string buffer = "chr1\t10\t20\nchr1\t+30\t 40\t\n";
+  std::vector<Interval> expected = {{"chr1", 10, 19}, {"chr1", 30, 39}};
+  EXPECT_EQ(parse_intervals_buffer(buffer.data(), buffer.size(), true), expected);
+}
+
+TEST(ParseIntervalsBufferTest, FailOnInvalidLines) {
+  std::vector<std::string> buffers = {"chr1\t10\t20\nchr1\t10\n", "chr1\t10\t20\t30\n", "chr1\tten\t20\n",
+                                      "chr1\t20\t10\n", "chr1\t-5\t10\n", "\n"};
+  for (const std::string &buffer : buffers) {
+    std::vector<Interval> intervals;
+    std::string error;
+    EXPECT_FALSE(parse_intervals_buffer(buffer.data(), buffer.size(), false, intervals, error)) << buffer;
+    EXPECT_FALSE(error.empty());
+  }
+}
+
+TEST(IntervalsCacheTest, RoundTripThroughFile) {
+  std::vector<Interval> intervals = merge_non_disjoint_intervals(
+      {{"chr2", 5, 10}, {"chr1", 0, 3}, {"chr2", 8, 12}, {"chr10", 7, 9}, {"chr1", 20, 25}});
+  std::string file_path = (std::filesystem::temp_directory_path() / "emcdp_intervals_cache_test.bin").string();
+  write_intervals_cache(file_path, intervals);
+
+  EXPECT_TRUE(is_intervals_cache_file(file_path));
+  EXPECT_EQ(load_intervals(file_path), intervals);
+
+  // flipping a byte of the payload has to be detected
+  {
+    std::fstream file(file_path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(sizeof(IntervalsCacheHeader) + 3);
+    file.put('x');
+  }
+  EXPECT_EXIT(load_intervals(file_path), testing::ExitedWithCode(1), "");
+  std::filesystem::remove(file_path);
+}
+
+// rewrites a chromosome entry of a cache and signs the cache again, so only the table checks can reject it
+static std::string with_cache_chr(std::string cache, size_t chr_idx, uint64_t first_interval, uint64_t interval_count) {
+  auto fnv = [](const char *data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t offset = 0; offset < size; offset += 8) {
+      uint64_t word;
+      std::memcpy(&word, data + offset, 8);
+      hash = (hash ^ word) * 1099511628211ULL;
+    }
+    return hash;
+  };
+
+  char *payload = cache.data() + sizeof(IntervalsCacheHeader);
+  IntervalsCacheChr chr;
+  std::memcpy(&chr, payload + chr_idx * sizeof(chr), sizeof(chr));
+  chr.first_interval = first_interval;
+  chr.interval_count = interval_count;
+  std::memcpy(payload + chr_idx * sizeof(chr), &chr, sizeof(chr));
+
+  IntervalsCacheHeader header;
+  std::memcpy(&header, cache.data(), sizeof(header));
+  header.payload_checksum = fnv(payload, header.payload_size);
+  header.header_checksum =
+      fnv(reinterpret_cast<const char *>(&header), offsetof(IntervalsCacheHeader, header_checksum));
+  std::memcpy(cache.data(), &header, sizeof(header));
+  return cache;
+}
+
+TEST(IntervalsCacheTest, FailOnInvalidChromosomeRanges) {
+  std::vector<Interval> intervals = {{"chr1", 0, 3}, {"chr1", 5, 8}, {"chr2", 1, 4}};
+  std::string file_path = (std::filesystem::temp_directory_path() / "emcdp_intervals_cache_ranges.bin").string();
+  write_intervals_cache(file_path, intervals);
+  std::stringstream content;
+  content << std::ifstream(file_path, std::ios::binary).rdbuf();
+  std::filesystem::remove(file_path);
+  std::string cache = content.str();
+
+  std::string same = with_cache_chr(cache, 1, 2, 1);
+  EXPECT_EQ(read_intervals_cache(same.data(), same.size(), "test"), intervals);
+
+  // overlapping ranges, ranges covering too few intervals and a range past the end
+  for (auto [first_interval, interval_count] : std::vector<std::pair<uint64_t, uint64_t>>{{0, 1}, {2, 0}, {1, 2}}) {
+    std::string invalid = with_cache_chr(cache, 1, first_interval, interval_count);
+    EXPECT_EXIT(read_intervals_cache(invalid.data(), invalid.size(), "test"), testing::ExitedWithCode(1), "");
+  }
+  std::string overflowing = with_cache_chr(cache, 1, UINT64_MAX, 2);
+  EXPECT_EXIT(read_intervals_cache(overflowing.data(), overflowing.size(), "test"), testing::ExitedWithCode(1), "");
+}
+
+// gzip member of `text`, with the BGZF extra field if `bgzf` is set
+static std::string gzip_member(const std::string &text, bool bgzf) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  std::string compressed(deflateBound(&stream, text.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+  stream.avail_in = text.size();
+  stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+  stream.avail_out = compressed.size();
+  deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  auto le = [](uint32_t value, int bytes) {
+    std::string result;
+    for (int idx = 0; idx < bytes; idx++)
+      result += (char)(value >> (8 * idx));
+    return result;
+  };
+  std::string header = {'\x1f', '\x8b', '\x08', bgzf ? '\x04' : '\x00', 0, 0, 0, 0, 0, '\xff'};
+  if (bgzf)
+    header += le(6, 2) + "BC" + le(2, 2) + le(header.size() + 8 + compressed.size() + 8 - 1, 2);
+  return header + compressed + le(crc32(0, reinterpret_cast<const Bytef *>(text.data()), text.size()), 4) +
+         le(text.size(), 4);
+}
+
+TEST(GzipInputTest, CompressedFilesMatchPlainText) {
+  std::string text;
+  for (int idx = 0; idx < 20000; idx++)
+    text += "chr" + std::to_string(idx % 3) + "\t" + std::to_string(idx * 10) + "\t" + std::to_string(idx * 10 + 7) +
+            "\n";
+  std::vector<Interval> expected = parse_intervals_buffer(text.data(), text.size());
+
+  // BGZF blocks split lines in the middle, plain gzip is written as two concatenated members
+  std::string bgzf, gzip = gzip_member(text.substr(0, 1000), false) + gzip_member(text.substr(1000), false);
+  for (size_t pos = 0; pos < text.size(); pos += 5000)
+    bgzf += gzip_member(text.substr(pos, 5000), true);
+  bgzf += gzip_member("", true);
+
+  for (const auto &[compressed, is_bgzf] : std::vector<std::pair<std::string, bool>>{{bgzf, true}, {gzip, false}}) {
+    GzipReader reader(compressed.data(), compressed.size(), "test");
+    EXPECT_EQ(reader.is_bgzf(), is_bgzf);
+    EXPECT_EQ(parse_intervals_stream(reader), expected);
+  }
+
+  std::string file_path = (std::filesystem::temp_directory_path() / "emcdp_gzip_test.tsv.gz").string();
+  std::ofstream(file_path, std::ios::binary) << bgzf;
+  EXPECT_EQ(load_intervals(file_path), expected);
+  std::filesystem::remove(file_path);
+}
+
+TEST(GzipInputTest, FailOnCorruptedBlock) {
+  std::string compressed = gzip_member("chr1\t1\t2\n", true);
+  compressed[compressed.size() - 9] ^= 1;
+  GzipReader reader(compressed.data(), compressed.size(), "test");
+  std::string text;
+  EXPECT_FALSE(reader.read_batch(text));
+  EXPECT_TRUE(reader.failed());
+  EXPECT_NE(reader.error().find("corrupted BGZF block"), std::string::npos);
+  EXPECT_FALSE(reader.read_batch(text));
+
+  std::string header_only = compressed.substr(0, 5);
+  GzipReader invalid_reader(header_only.data(), header_only.size(), "test");
+  EXPECT_FALSE(invalid_reader.read_batch(text));
+  EXPECT_TRUE(invalid_reader.failed());
+}
+
+TEST(PreprocessIntervalsTest, MatchesSeparateSteps) {
+  ChrSizesMap chr_sizes = {{"chr1", 1000}, {"chr2", 1000}};
+  std::mt19937 rng(11);
+  std::vector<Interval> intervals;
+  for (int idx = 0; idx < 500; idx++) {
+    long long begin = rng() % 900, length = rng() % 20;
+    intervals.push_back({"chr" + std::to_string(1 + rng() % 3), begin, begin + length});
+  }
+
+  std::unordered_set<std::string> chr_names = load_chr_names_from_chr_sizes(chr_sizes);
+  std::vector<Interval> expected =
+      remove_empty_intervals(merge_non_disjoint_intervals(filter_intervals_by_chr_name(intervals, chr_names)));
+
+  std::vector<Interval> windows = intervals;
+  preprocess_intervals(intervals, chr_sizes);
+  EXPECT_EQ(intervals, expected);
+
+  // without merging only filtering, sorting and dropping empty intervals is done
+  std::vector<Interval> expected_windows = remove_empty_intervals(filter_intervals_by_chr_name(windows, chr_names));
+  std::sort(expected_windows.begin(), expected_windows.end());
+  preprocess_intervals(windows, chr_sizes, false);
+  EXPECT_EQ(windows, expected_windows);
+}
+
+TEST(RadixSortTest, IntervalsMatchComparisonSort) {
+  std::mt19937 rng(3);
+  for (size_t count : {100, 20000}) {
+    std::vector<Interval> intervals;
+    for (size_t idx = 0; idx < count; idx++) {
+      long long begin = (long long)(rng() % 100000) - 1000;
+      intervals.push_back({(uint32_t)(rng() % 300), begin, begin + (long long)(rng() % 50)});
+    }
+    std::vector<Interval> expected = intervals;
+    std::sort(expected.begin(), expected.end());
+    sort_intervals(intervals);
+    EXPECT_EQ(intervals, expected);
+  }
+}
+
+TEST(RadixSortTest, IsStable) {
+  std::mt19937 rng(4);
+  std::vector<std::pair<uint64_t, size_t>> values;
+  for (size_t idx = 0; idx < 50000; idx++)
+    values.push_back({(uint64_t)(rng() % 1000) << 40, idx});
+  std::vector<std::pair<uint64_t, size_t>> expected = values;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const auto &a, const auto &b) { return a.first < b.first; });
+  radix_sort(values, [](const std::pair<uint64_t, size_t> &value) { return value.first; });
+  EXPECT_EQ(values, expected);
+}
+
+TEST(ChrDictionaryTest, NamesAndIdsRoundTrip) {
+  uint32_t chr1 = ChrDictionary::get_id("chr1"), chr_x = ChrDictionary::get_id("chrX");
+  EXPECT_NE(chr1, chr_x);
+  EXPECT_EQ(ChrDictionary::get_id("chr1"), chr1);
+  EXPECT_EQ(ChrDictionary::get_name(chr_x), "chrX");
+  EXPECT_EQ(ChrDictionary::get_id(""), 0u);
+  EXPECT_EQ(Interval("chrX", 1, 2), Interval(chr_x, 1, 2));
+  EXPECT_EQ(std::string(Interval(chr_x, 1, 2)), "chrX: [1, 2)");
+}
+
+TEST(IntervalsViewTest, SplitByRangesClipsBorderIntervals) {
+  auto intervals = std::make_shared<const IntervalColumns>(
+      std::vector<Interval>{{"", 1, 10}, {"", 20, 30}, {"", 35, 40}});
+  auto views = IntervalsView::split_by_ranges(intervals, {{0, 5}, {5, 25}, {25, 32}, {32, 50}});
+  std::vector<std::vector<Interval>> expected = {
+      {{"", 1, 5}}, {{"", 5, 10}, {"", 20, 25}}, {{"", 25, 30}}, {{"", 35, 40}}};
+  ASSERT_EQ(views.size(), expected.size());
+  for (size_t idx = 0; idx < views.size(); idx++)
+    EXPECT_EQ(views[idx].to_vector(), expected[idx]);
+}
+
+TEST(IntervalsViewTest, JoinRestoresIntervalOverBorder) {
+  auto intervals = std::make_shared<const IntervalColumns>(
+      std::vector<Interval>{{"", 1, 10}, {"", 20, 30}, {"", 35, 40}});
+  auto views = IntervalsView::split_by_ranges(intervals, {{0, 25}, {25, 38}});
+  std::vector<Interval> expected = {{"", 1, 10}, {"", 20, 30}, {"", 35, 38}};
+  EXPECT_EQ(IntervalsView::join(views[0], views[1]).to_vector(), expected);
+}
+
 TEST(GetWindowsIntervalsTest, NestedWindow) {
   std::vector<Interval> intervals = {{"", 7, 12}};
   std::vector<Interval> windows = {{"", 5, 10}, {"", 0, 20}};
@@ -207,8 +945,8 @@ TEST(SplitWindowsTest, IntervalOverflow) {
       windows, {{"chr1", 100, 250}, {"chr1", 270, 300}}, {{"chr1", 100, 250}, {"chr1", 270, 300}});
 
   ASSERT_EQ(result.get_sections().size(), 2);
-  EXPECT_EQ(result.get_sections()[0], Section("chr1", 100, 200, false, true, false, true));
-  EXPECT_EQ(result.get_sections()[1], Section("chr1", 200, 300, true, false, true, false));
+  EXPECT_EQ(result.get_sections()[0], Section(ChrDictionary::get_id("chr1"), 100, 200, false, true, false, true));
+  EXPECT_EQ(result.get_sections()[1], Section(ChrDictionary::get_id("chr1"), 200, 300, true, false, true, false));
 
   ASSERT_EQ(result.get_spans().size(), 2);
   EXPECT_EQ(result.get_spans()[0], Interval("chr1", 0, 1));
@@ -224,15 +962,15 @@ TEST(SplitWindowsTest, EdgeCase1) {
   WindowSectionSplitResult result = split_windows_into_non_overlapping_sections(windows, ref_ints, query_ints);
 
   ASSERT_EQ(result.get_sections().size(), 9);
-  EXPECT_EQ(result.get_sections()[0], Section("chr1", 1500, 1650, false, false, false, false));
-  EXPECT_EQ(result.get_sections()[1], Section("chr1", 1650, 1800, false, false, false, false));
-  EXPECT_EQ(result.get_sections()[2], Section("chr1", 1800, 1950, false, false, false, false));
-  EXPECT_EQ(result.get_sections()[3], Section("chr1", 1950, 2100, false, false, false, true));
-  EXPECT_EQ(result.get_sections()[4], Section("chr1", 2100, 2250, false, false, true, false));
-  EXPECT_EQ(result.get_sections()[5], Section("chr1", 2250, 2400, false, false, false, true));
-  EXPECT_EQ(result.get_sections()[6], Section("chr1", 2400, 2550, false, false, true, true));
-  EXPECT_EQ(result.get_sections()[7], Section("chr1", 2550, 2700, false, true, true, true));
-  EXPECT_EQ(result.get_sections()[8], Section("chr1", 2700, 2850, true, false, true, false));
+  EXPECT_EQ(result.get_sections()[0], Section(ChrDictionary::get_id("chr1"), 1500, 1650, false, false, false, false));
+  EXPECT_EQ(result.get_sections()[1], Section(ChrDictionary::get_id("chr1"), 1650, 1800, false, false, false, false));
+  EXPECT_EQ(result.get_sections()[2], Section(ChrDictionary::get_id("chr1"), 1800, 1950, false, false, false, false));
+  EXPECT_EQ(result.get_sections()[3], Section(ChrDictionary::get_id("chr1"), 1950, 2100, false, false, false, true));
+  EXPECT_EQ(result.get_sections()[4], Section(ChrDictionary::get_id("chr1"), 2100, 2250, false, false, true, false));
+  EXPECT_EQ(result.get_sections()[5], Section(ChrDictionary::get_id("chr1"), 2250, 2400, false, false, false, true));
+  EXPECT_EQ(result.get_sections()[6], Section(ChrDictionary::get_id("chr1"), 2400, 2550, false, false, true, true));
+  EXPECT_EQ(result.get_sections()[7], Section(ChrDictionary::get_id("chr1"), 2550, 2700, false, true, true, true));
+  EXPECT_EQ(result.get_sections()[8], Section(ChrDictionary::get_id("chr1"), 2700, 2850, true, false, true, false));
 
   ASSERT_EQ(result.get_spans().size(), 5);
   EXPECT_EQ(result.get_spans()[0], Interval("chr1", 0, 5));
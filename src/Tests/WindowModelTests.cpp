@@ -2,6 +2,8 @@
 #include "../Interval/Interval.hpp"
 #include "../Model/WindowModel.hpp"
 #include <gtest/gtest.h>
+#include <omp.h>
+#include <tuple>
 
 class WindowModelRunTest : public ::testing::Test {
 protected:
@@ -257,6 +259,104 @@ TEST_F(WindowModelRunTest, SmallTest2) {
   }
 }
 
+TEST_F(WindowModelRunTest, SlidingMatchesSegTree) {
+  ChrSizesMap chr_sizes_map = {{"chr1", 10000}};
+  std::vector<std::vector<Interval>> windows_sets(3);
+  for (long long begin = 0; begin + 2000 <= 10000; begin += 150)
+    windows_sets[0].push_back({"chr1", begin, begin + 2000});
+  for (long long begin = 0; begin + 700 <= 10000; begin += 700)
+    windows_sets[1].push_back({"chr1", begin, begin + 700});
+  windows_sets[2] = {{"chr1", 0, 6000}, {"chr1", 1000, 3000}, {"chr1", 2000, 9000}, {"chr1", 2500, 2600}};
+
+  for (const std::vector<Interval> &windows : windows_sets) {
+    std::vector<WindowResult> resultsNaive =
+        WindowModel(windows, ref_intervals, query_intervals, chr_sizes_map, Algorithm::NAIVE).run();
+    std::vector<WindowResult> resultsFast =
+        WindowModel(windows, ref_intervals, query_intervals, chr_sizes_map, Algorithm::FAST).run();
+    std::vector<WindowResult> resultsSliding =
+        WindowModel(windows, ref_intervals, query_intervals, chr_sizes_map, Algorithm::SLIDING).run();
+    ASSERT_EQ(resultsNaive.size(), resultsSliding.size());
+    for (size_t i = 0; i < resultsNaive.size(); i++) {
+      ASSERT_EQ(resultsNaive[i], resultsSliding[i]);
+      ASSERT_EQ(resultsFast[i], resultsSliding[i]);
+    }
+  }
+}
+
+TEST_F(WindowModelRunTest, SparseTableMatchesSegTree) {
+  ChrSizesMap chr_sizes_map = {{"chr1", 10000}};
+  std::vector<Interval> windows;
+  for (long long begin = 0; begin + 2000 <= 10000; begin += 150)
+    windows.push_back({"chr1", begin, begin + 2000});
+  windows.push_back({"chr1", 2500, 2600});
+
+  std::vector<WindowResult> resultsNaive =
+      WindowModel(windows, ref_intervals, query_intervals, chr_sizes_map, Algorithm::NAIVE).run();
+  std::vector<WindowResult> resultsSparse =
+      WindowModel(windows, ref_intervals, query_intervals, chr_sizes_map, Algorithm::SPARSE).run();
+  // zero budget forces the segment tree fallback
+  std::vector<WindowResult> resultsFallback =
+      WindowModel(windows, ref_intervals, query_intervals, chr_sizes_map, Algorithm::SPARSE, 0).run();
+  ASSERT_EQ(resultsNaive.size(), resultsSparse.size());
+  for (size_t i = 0; i < resultsNaive.size(); i++) {
+    ASSERT_EQ(resultsNaive[i], resultsSparse[i]);
+    ASSERT_EQ(resultsNaive[i], resultsFallback[i]);
+  }
+}
+
+// sets the OpenMP thread count back when the test ends, even when an assertion returned early
+class ThreadCountGuard {
+public:
+  ThreadCountGuard() : max_threads(omp_get_max_threads()) {}
+  ~ThreadCountGuard() { omp_set_num_threads(max_threads); }
+
+private:
+  int max_threads;
+};
+
+TEST_F(WindowModelRunTest, ManyThreadsMatchSingleThread) {
+  // the same intervals on many chromosomes of different sizes, so that threads finish in different orders
+  std::vector<Interval> ref_ints, query_ints, windows;
+  ChrSizesMap chr_sizes_map;
+  for (int chr_idx = 0; chr_idx < 24; chr_idx++) {
+    std::string chr_name = "chr" + std::to_string(chr_idx);
+    long long repeats = 1 + chr_idx % 5, chr_size = 10000 * repeats;
+    chr_sizes_map[chr_name] = chr_size;
+    for (long long repeat = 0; repeat < repeats; repeat++) {
+      for (const Interval &interval : ref_intervals)
+        ref_ints.push_back({chr_name, interval.begin + 10000 * repeat, interval.end + 10000 * repeat});
+      for (const Interval &interval : query_intervals)
+        query_ints.push_back({chr_name, interval.begin + 10000 * repeat, interval.end + 10000 * repeat});
+    }
+    for (long long begin = 0; begin + 2000 <= chr_size; begin += 500)
+      windows.push_back({chr_name, begin, begin + 2000});
+  }
+
+  // results follow the order of chromosome names, not of chromosome ids
+  std::vector<Interval> sorted_windows = windows;
+  std::sort(sorted_windows.begin(), sorted_windows.end(), [](const Interval &a, const Interval &b) {
+    return std::tie(a.get_chr_name(), a.begin, a.end) < std::tie(b.get_chr_name(), b.begin, b.end);
+  });
+
+  ThreadCountGuard thread_count_guard;
+  for (Algorithm algorithm :
+       {Algorithm::NAIVE, Algorithm::SLOW, Algorithm::FAST, Algorithm::SLIDING, Algorithm::SPARSE}) {
+    omp_set_num_threads(1);
+    std::vector<WindowResult> expected = WindowModel(windows, ref_ints, query_ints, chr_sizes_map, algorithm).run();
+    ASSERT_EQ(expected.size(), sorted_windows.size());
+    for (size_t i = 0; i < expected.size(); i++)
+      ASSERT_EQ(expected[i].get_window(), sorted_windows[i]);
+
+    omp_set_num_threads(16);
+    for (int repeat = 0; repeat < 5; repeat++) {
+      std::vector<WindowResult> results = WindowModel(windows, ref_ints, query_ints, chr_sizes_map, algorithm).run();
+      ASSERT_EQ(expected.size(), results.size());
+      for (size_t i = 0; i < expected.size(); i++)
+        ASSERT_EQ(expected[i], results[i]);
+    }
+  }
+}
+
 TEST(LargeWindowModelTest, LargeTests) {
   Args args1(logger);
   args1.ref_intervals_file_path = "test_data/g24_8.ref.tsv";
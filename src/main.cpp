@@ -1,16 +1,22 @@
 #include "Args/Args.hpp"
 #include "Enums/Enums.hpp"
+#include "Generator/Generator.hpp"
 #include "Helpers/Helpers.hpp"
+#include "IntervalsLoader/IntervalsCache.hpp"
 #include "Logger/Logger.hpp"
+#include "Model/BasesModel.hpp"
 #include "Model/Model.hpp"
 #include "Model/WindowModel.hpp"
 #include "Output/Output.hpp"
+#include "Profiler/Profiler.hpp"
 #include "Stats/Stats.hpp"
 #include "Timer/Timer.hpp"
 
 #include <chrono>
 #include <gtest/gtest.h>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -46,8 +52,29 @@ int main(int argc, char *argv[]) {
     logger.info(
         "--windows.step <windows-step>\t\t\t\t- required with the `--windows.source dense` flag, tells the program "
         "the shift when generating overlapping set of windows");
-    logger.info("--algorithm <naive|slow_bad|slow|fast_bad|fast>\t- defaults to naive, is used to choose algorithm "
-                "when evaluating windows");
+    logger.info("--algorithm <naive|slow_bad|slow|fast_bad|fast|sliding|sparse>\t- defaults to naive, is used to "
+                "choose algorithm when evaluating windows, sliding is the fastest for dense windows");
+    logger.info("--memory.budget <megabytes>\t\t\t- defaults to 4096, chromosomes whose sparse table would take "
+                "more memory use a segment tree with the sparse algorithm");
+    logger.info("--statistic <overlaps|bases>\t\t\t- defaults to overlaps, bases counts covered reference bases "
+                "instead of hit reference intervals, genome-wide it runs best with a small --epsilon");
+    logger.info("--epsilon <value>\t\t\t\t- defaults to 0, if positive the genome-wide DP drops at most this much "
+                "probability mass over all chromosomes together to skip overlap counts that are practically "
+                "impossible");
+    logger.info("--profile <path-to-json-file>\t\t\t- writes the time and counters (DP cells, matrix powers, joins, "
+                "bytes read) of every phase of the run into this file, by thread and by chromosome");
+    logger.info("convert --i <path-to-your-intervals-file> --o <path-to-binary-file>\t- writes the intervals sorted "
+                "and merged into a binary file, which can be passed to --r or --q instead of the text file");
+    logger.info("generate --chs <path-to-your-chromosome-sizes-file> --o <output-prefix>\t- samples a synthetic "
+                "reference and query into <output-prefix>.ref.tsv and <output-prefix>.query.tsv, the optional --r and "
+                "--q give tracks to fit the chains of the samples to");
+    logger.info("--generate.seed <seed>\t\t\t\t- defaults to 1, the same seed and flags give the same intervals");
+    logger.info("--generate.ref_density <density> --generate.ref_length <bases>\t- defaults to 0.05 and 500, the "
+                "covered fraction and mean interval length of the reference when --r is not given");
+    logger.info("--generate.query_density <density> --generate.query_length <bases>\t- defaults to 0.5 and 500, "
+                "the same for the query when --q is not given");
+    logger.info("--generate.format <tsv|binary>\t\t\t- defaults to tsv, binary writes the files of `convert` "
+                "with the .bin extension");
     logger.info("--test\t\t\t\t\t\t- if this flag is specified, all other flags (except `--help`) are ignored and all "
                 "the tests "
                 "in the `src/Tests` are ran and then the program quits");
@@ -72,35 +99,83 @@ int main(int argc, char *argv[]) {
   if (args.log_file_path != "")
     logger = Logger(args.log_file_path);
 
+  if (args.convert) {
+    logger.info("Converting intervals from: " + args.input_file_path);
+    std::vector<Interval> intervals = load_intervals(args.input_file_path);
+    size_t raw_count = intervals.size();
+    intervals = merge_non_disjoint_intervals(intervals);
+    intervals = remove_empty_intervals(intervals);
+
+    write_intervals_cache(args.output_file_path, intervals);
+    logger.info("Wrote " + std::to_string(intervals.size()) + " intervals (" + std::to_string(raw_count) +
+                " before merging) into: " + args.output_file_path);
+    return 0;
+  }
+
+  if (args.generate) {
+    logger.info("Loading chromosome sizes from: " + args.chr_size_file_path);
+    std::unordered_map<std::string, long long> chr_sizes = load_chr_sizes(args.chr_size_file_path);
+    ChrSizesVector chr_sizes_vector = chr_sizes_map_to_array(chr_sizes);
+
+    std::vector<std::pair<std::string, std::vector<std::optional<MarkovChain>>>> tracks;
+    std::vector<std::tuple<std::string, std::string, long double, long double>> track_sources = {
+        {"ref", args.ref_intervals_file_path, args.generate_ref_density, args.generate_ref_length},
+        {"query", args.query_intervals_file_path, args.generate_query_density, args.generate_query_length}};
+    for (const auto &[name, file_path, density, mean_length] : track_sources) {
+      if (file_path.empty()) {
+        std::optional<MarkovChain> chain = markov_chain_from_density(density, mean_length);
+        tracks.push_back({name, std::vector<std::optional<MarkovChain>>(chr_sizes_vector.size(), chain)});
+        continue;
+      }
+
+      logger.info("Fitting the " + name + " chains to: " + file_path);
+      std::vector<Interval> intervals = load_intervals(file_path);
+      preprocess_intervals(intervals, chr_sizes);
+      tracks.push_back({name, fit_markov_chains(chr_sizes_vector, intervals)});
+    }
+
+    for (uint32_t track = 0; track < tracks.size(); track++) {
+      std::vector<Interval> intervals =
+          generate_intervals(chr_sizes_vector, tracks[track].second, args.generate_seed, track);
+      std::string file_path = args.output_file_path + "." + tracks[track].first;
+      if (args.generate_format == "binary") {
+        file_path += ".bin";
+        write_intervals_cache(file_path, intervals);
+      } else {
+        file_path += ".tsv";
+        write_intervals_tsv(file_path, intervals);
+      }
+      logger.info("Wrote " + std::to_string(intervals.size()) + " " + tracks[track].first +
+                  " intervals into: " + file_path);
+    }
+    return 0;
+  }
+
+  if (!args.profile_file_path.empty())
+    profiler.enable();
+
   Output output(args.output_file_path);
 
+  // chromosome sizes go first, they fill the chromosome dictionary before any interval is read
+  ProfileScope loading_scope(Phase::LOADING);
+  logger.info("Loading chromosome sizes from: " + args.chr_size_file_path);
+  std::unordered_map<std::string, long long> chr_sizes = load_chr_sizes(args.chr_size_file_path);
+
   logger.info("Loading reference interval set from: " + args.ref_intervals_file_path);
   std::vector<Interval> ref_intervals = load_intervals(args.ref_intervals_file_path);
 
   logger.info("Loading query interval set from: " + args.query_intervals_file_path);
   std::vector<Interval> query_intervals = load_intervals(args.query_intervals_file_path);
 
-  logger.info("Loading chromosome sizes from: " + args.chr_size_file_path);
-  std::unordered_map<std::string, long long> chr_sizes = load_chr_sizes(args.chr_size_file_path);
+  loading_scope.stop();
 
   size_t raw_ref_count = ref_intervals.size();
   size_t raw_query_count = query_intervals.size();
 
-  std::unordered_set<std::string> chr_names = load_chr_names_from_chr_sizes(chr_sizes);
-
-  ref_intervals = filter_intervals_by_chr_name(ref_intervals, chr_names);
-  query_intervals = filter_intervals_by_chr_name(query_intervals, chr_names);
-
-  ref_intervals = merge_non_disjoint_intervals(ref_intervals);
-  query_intervals = merge_non_disjoint_intervals(query_intervals);
-
-  ref_intervals = remove_empty_intervals(ref_intervals);
-  query_intervals = remove_empty_intervals(query_intervals);
-
-  if (args.statistic == Statistic::BASES) {
-    ref_intervals = split_intervals_into_ones(ref_intervals);
-    query_intervals = split_intervals_into_ones(query_intervals);
-  }
+  ProfileScope preprocessing_scope(Phase::PREPROCESSING);
+  preprocess_intervals(ref_intervals, chr_sizes);
+  preprocess_intervals(query_intervals, chr_sizes);
+  preprocessing_scope.stop();
 
   logger.info("Number of reference intervals: " + std::to_string(ref_intervals.size()) + " (" +
               std::to_string(raw_ref_count) + " before merging)");
@@ -111,21 +186,34 @@ int main(int argc, char *argv[]) {
   if (!args.windows_source.empty()) {
     // ideme pocitat pre okna
     logger.info("Loading window sizes...");
+    ProfileScope windows_loading_scope(Phase::LOADING);
     std::vector<Interval> windows = load_windows(args, chr_sizes);
+    windows_loading_scope.stop();
     long long raw_window_count = windows.size();
-    windows = filter_intervals_by_chr_name(windows, chr_names);
-    windows = remove_empty_intervals(windows);
+    ProfileScope windows_preprocessing_scope(Phase::PREPROCESSING);
+    preprocess_intervals(windows, chr_sizes, false);
 
     logger.info("Number of windows: " + std::to_string(windows.size()) + " (" + std::to_string(raw_window_count) +
                 " before preprocessing)");
 
-    WindowModel model(windows, ref_intervals, query_intervals, chr_sizes, args.algorithm);
+    // window models count hit intervals, so for the bases statistic every base is still an interval of its own here
+    if (args.statistic == Statistic::BASES) {
+      ref_intervals = split_intervals_into_ones(ref_intervals);
+      query_intervals = split_intervals_into_ones(query_intervals);
+    }
+    windows_preprocessing_scope.stop();
+
+    WindowModel model(std::move(windows), std::move(ref_intervals), std::move(query_intervals), chr_sizes,
+                      args.algorithm, args.memory_budget);
     std::vector<WindowResult> results = model.run();
 
     output.print("chr_name\tbegin\tend\toverlap_count\tp-value\tp-value_adjusted\tmean\tvariance\tstandard_"
                  "deviation\tz-score\n");
     for (WindowResult result : results) {
+      ProfileScope stats_scope(Phase::STATS);
       Stats stats(result, args.significance);
+      stats_scope.stop();
+      ProfileScope output_scope(Phase::OUTPUT);
       output.print(std::format("{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\t{}\n", stats.get_window().get_chr_name(),
                                stats.get_window().get_begin(), stats.get_window().get_end(), result.get_overlap_count(),
                                stats.get_pvalue(), std::min(1.L, stats.get_pvalue() * results.size()), stats.get_mean(),
@@ -135,15 +223,28 @@ int main(int argc, char *argv[]) {
     long double duration = timer.elapsed<std::chrono::milliseconds>();
     logger.debug("Time taken to calculate p-value: " + std::to_string(duration) + " milliseconds\n");
   } else {
-    long long overlap_count = count_overlaps(ref_intervals, query_intervals);
-    logger.info("Overlap count: " + std::to_string(overlap_count));
-
     // ideme pocitat pre cely genom spolu
-    Model model(ref_intervals, query_intervals, chr_sizes);
+    long long overlap_count;
+    std::vector<long double> probs;
+    if (args.statistic == Statistic::BASES) {
+      overlap_count = count_overlapping_bases(ref_intervals, query_intervals);
+      logger.info("Overlap count: " + std::to_string(overlap_count));
+
+      BasesModel model(std::move(ref_intervals), std::move(query_intervals), chr_sizes, args.epsilon);
+      probs = model.eval_probs(overlap_count);
+    } else {
+      overlap_count = count_overlaps(ref_intervals, query_intervals);
+      logger.info("Overlap count: " + std::to_string(overlap_count));
+
+      Model model(std::move(ref_intervals), std::move(query_intervals), chr_sizes, args.epsilon);
+      probs = model.eval_probs(overlap_count);
+    }
 
-    std::vector<long double> probs = model.eval_probs(overlap_count);
     WindowResult result({}, overlap_count, probs);
+    ProfileScope stats_scope(Phase::STATS);
     Stats stats(result, args.significance);
+    stats_scope.stop();
+    ProfileScope output_scope(Phase::OUTPUT);
     output.print("overlap_count\tp-value\tmean\tvariance\tstandard_deviation\tz-score\n");
     output.print(std::format("{}\t{}\t{}\t{}\t{}\t{}\n", result.get_overlap_count(), stats.get_pvalue(),
                              stats.get_mean(), stats.get_variance(), stats.get_standard_deviation(),
@@ -153,5 +254,10 @@ int main(int argc, char *argv[]) {
     logger.debug("Time taken to calculate p-value: " + std::to_string(duration) + " milliseconds\n");
   }
 
+  if (!args.profile_file_path.empty()) {
+    profiler.write_report(args.profile_file_path);
+    logger.info("Wrote the profile into: " + args.profile_file_path);
+  }
+
   return 0;
 }